@@ -7,9 +7,33 @@
 .. moduleauthor:: James Reed <jcrd@sessiond.org>
 """
 
+import os
+
 import dbus
+import dbus.connection
 
 BUS_NAME = "org.sessiond.session1"
+PEER_SOCKET = os.path.join("sessiond", "bus")
+
+
+def connect():
+    """
+    Connect to sessiond's private socket if it exists, otherwise to the \
+    session bus.
+
+    :return: Tuple of the connection and the bus name to address, which is \
+    None for a private connection
+    """
+    runtime = os.environ.get("XDG_RUNTIME_DIR")
+    if runtime:
+        path = os.path.join(runtime, PEER_SOCKET)
+        if os.path.exists(path):
+            try:
+                conn = dbus.connection.Connection("unix:path=" + path)
+                return (conn, None)
+            except dbus.exceptions.DBusException:
+                pass
+    return (dbus.SessionBus(), BUS_NAME)
 
 
 class DBusIFace:
@@ -20,7 +44,7 @@ class DBusIFace:
     :param iface: DBus interface name
     """
 
-    bus = dbus.SessionBus()
+    bus, bus_name = connect()
 
     @staticmethod
     def convert(val):
@@ -40,11 +64,13 @@ class DBusIFace:
             return float(val)
         if isinstance(val, dbus.Array):
             return list(map(DBusIFace.convert, list(val)))
+        if isinstance(val, dbus.Struct):
+            return tuple(map(DBusIFace.convert, list(val)))
 
         return None
 
     def __init__(self, path, iface):
-        self.obj = DBusIFace.bus.get_object(BUS_NAME, path)
+        self.obj = DBusIFace.bus.get_object(DBusIFace.bus_name, path)
         self.iface = "{}.{}".format(BUS_NAME, iface)
         self.props = dbus.Interface(
             self.obj, dbus_interface="org.freedesktop.DBus.Properties"
@@ -103,6 +129,25 @@ class Backlight(DBusIFace):
         """
         return self.interface.IncBrightness(v)
 
+    def set_brightness_percent(self, p):
+        """
+        Set the backlight's brightness along its perceptual curve.
+
+        :param p: Position on the curve, between 0 and 1
+        :raises dbus.exception.DBusException: Raised if unable to set brightness
+        """
+        self.interface.SetBrightnessPercent(p)
+
+    def inc_brightness_percent(self, v):
+        """
+        Increment the backlight's brightness along its perceptual curve.
+
+        :param v: Value by which to increment the position on the curve
+        :return: The new position on the curve
+        :raises dbus.exception.DBusException: Raised if unable to set brightness
+        """
+        return self.interface.IncBrightnessPercent(v)
+
     @property
     def online(self):
         """
@@ -158,6 +203,46 @@ class Backlight(DBusIFace):
         return self.get_property("Brightness")
 
 
+class BacklightGroup(DBusIFace):
+    """
+    An interface to a sessiond BacklightGroup object.
+
+    :param name: The backlight group's name
+    """
+
+    def __init__(self, name):
+        self.name = name
+        path = "/org/sessiond/session1/backlightgroup/{}".format(self.name)
+        super().__init__(path, "BacklightGroup")
+
+    def set_brightness(self, v):
+        """
+        Set the brightness of the group's members.
+
+        :param v: Brightness value
+        :raises dbus.exception.DBusException: Raised if unable to set brightness
+        """
+        self.interface.SetBrightness(v)
+
+    def inc_brightness(self, v):
+        """
+        Increment the brightness of the group's members.
+
+        :param v: Brightness value by which to increment
+        :raises dbus.exception.DBusException: Raised if unable to set brightness
+        """
+        self.interface.IncBrightness(v)
+
+    @property
+    def members(self):
+        """
+        Group's members.
+
+        :return: A list of the members' /sys paths
+        """
+        return self.get_property("Members")
+
+
 class AudioSink(DBusIFace):
     """
     An interface to a sessiond AudioSink object.
@@ -262,6 +347,28 @@ class Session(DBusIFace):
         """
         return self.interface.Inhibit(who, why)
 
+    def inhibit_for(self, sec, who="", why=""):
+        """
+        Add an inhibitor that stops on its own.
+
+        :param sec: Seconds before the inhibitor expires
+        :param who: A string describing who is inhibiting
+        :param why: A string describing why this inhibitor is running
+        :return: The inhibitor's ID
+        """
+        return self.interface.InhibitFor(who, why, sec)
+
+    def inhibit_fd(self, who="", why=""):
+        """
+        Add an inhibitor that runs until a file descriptor is closed.
+
+        :param who: A string describing who is inhibiting
+        :param why: A string describing why this inhibitor is running
+        :return: Tuple of the file descriptor and the inhibitor's ID
+        """
+        fd, id = self.interface.InhibitFd(who, why)
+        return (fd.take(), id)
+
     def uninhibit(self, id):
         """
         Remove an inhibitor.
@@ -292,6 +399,74 @@ class Session(DBusIFace):
             for k, s in self.interface.ListInhibitors().items()
         }
 
+    def get_inhibitor_expiries(self):
+        """
+        Get the remaining time of inhibitors that expire.
+
+        :return: A dictionary mapping IDs to seconds remaining before expiry
+        """
+        return {
+            str(k): int(t)
+            for k, t in self.interface.GetInhibitorExpiries().items()
+        }
+
+    def get_state(self):
+        """
+        Get a snapshot of the session's state.
+
+        :return: A dictionary of the session's hints, a list of tuples of \
+        each backlight's path, name, brightness and max brightness, and a \
+        list of tuples of each audio sink's path, name, volume and mute state
+        """
+        return {
+            str(k): self.convert(v)
+            for k, v in self.interface.GetState().items()
+        }
+
+    def add_inactive_timeout(self, sec):
+        """
+        Register a timeout after which the Inactive signal is emitted to this \
+        connection. It is removed when the connection is closed.
+
+        :param sec: Seconds of inactivity
+        """
+        self.interface.AddInactiveTimeout(dbus.UInt32(sec))
+
+    def remove_inactive_timeout(self, sec):
+        """
+        Remove a timeout registered with add_inactive_timeout.
+
+        :param sec: Seconds of inactivity
+        :raises dbus.exception.DBusException: Raised if the timeout is not \
+        registered
+        """
+        self.interface.RemoveInactiveTimeout(dbus.UInt32(sec))
+
+    def set_inactive_progress(self, sec):
+        """
+        Receive the InactiveProgress signal every sec seconds of inactivity.
+
+        :param sec: Interval in seconds, or 0 to stop the signal
+        """
+        self.interface.SetInactiveProgress(dbus.UInt32(sec))
+
+    def subscribe(self, from_seq=0):
+        """
+        Subscribe to the Event signal, replaying kept events with a sequence \
+        number of at least from_seq.
+
+        :param from_seq: Sequence number of the first event to replay
+        :return: Sequence number of the first event replayed, greater than \
+        from_seq if events were lost
+        """
+        return int(self.interface.Subscribe(dbus.UInt64(from_seq)))
+
+    def unsubscribe(self):
+        """
+        Remove the subscription to the Event signal.
+        """
+        self.interface.Unsubscribe()
+
     def lock(self):
         """
         Lock the session.
@@ -319,6 +494,15 @@ class Session(DBusIFace):
         """
         return self.get_property("Backlights")
 
+    @property
+    def backlight_groups(self):
+        """
+        List of backlight groups.
+
+        :return: A list of BacklightGroup DBus object paths
+        """
+        return self.get_property("BacklightGroups")
+
     @property
     def audiosinks(self):
         """
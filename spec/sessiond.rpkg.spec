@@ -51,7 +51,9 @@ cd python-sessiond
 %doc README.md
 %{_bindir}/sessionctl
 %{_bindir}/sessiond
+%{_bindir}/sessiond-call
 %{_bindir}/sessiond-inhibit
+%{_includedir}/sessiond/sessiond-state.h
 /usr/lib/systemd/user/graphical-idle.target
 /usr/lib/systemd/user/graphical-lock.target
 /usr/lib/systemd/user/graphical-unidle.target
@@ -62,6 +64,7 @@ cd python-sessiond
 /usr/lib/systemd/user/user-sleep.target
 /usr/lib/systemd/user/user-sleep-finished.target
 %{_mandir}/man1/sessionctl.1.gz
+%{_mandir}/man1/sessiond-call.1.gz
 %{_mandir}/man1/sessiond-inhibit.1.gz
 %{_mandir}/man1/sessiond.1.gz
 %{_mandir}/man5/sessiond-hooks.5.gz
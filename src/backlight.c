@@ -23,6 +23,7 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 #include "dbus-logind.h"
 
 #include <errno.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -59,32 +60,85 @@ get_uint_sysattr(struct Backlight *b, const char *attr)
     return i;
 }
 
+static void
+default_curve(const char *subsystem, BacklightCurve *curve, gdouble *gamma)
+{
+    if (g_strcmp0(subsystem, "backlight") == 0)
+        *curve = BL_CURVE_GAMMA;
+    else
+        *curve = BL_CURVE_LINEAR;
+    *gamma = 2.2;
+}
+
+static gdouble
+curve_value(BacklightCurve curve, gdouble gamma, gint32 max, gdouble p)
+{
+    switch (curve) {
+        case BL_CURVE_GAMMA:
+            return pow(p, gamma) * max;
+        case BL_CURVE_LOG:
+            return pow(max + 1, p) - 1;
+        case BL_CURVE_LINEAR:
+        default:
+            return p * max;
+    }
+}
+
+/* Precompute the raw brightness at BL_LEVELS + 1 evenly spaced points along
+ * the backlight's curve. */
+static void
+build_levels(struct Backlight *bl)
+{
+    g_clear_pointer(&bl->levels, g_free);
+
+    if (bl->max_brightness <= 0)
+        return;
+
+    bl->levels = g_new(guint32, BL_LEVELS + 1);
+
+    for (guint i = 0; i <= BL_LEVELS; i++) {
+        gdouble v = curve_value(bl->curve, bl->gamma, bl->max_brightness,
+                (gdouble)i / BL_LEVELS);
+        bl->levels[i] = CLAMP(v + 0.5, 0, bl->max_brightness);
+    }
+}
+
 static gboolean
 update_backlight(struct Backlight *bl, struct udev_device *dev)
 {
+    gint32 max = bl->max_brightness;
+
     if (bl->device)
         udev_device_unref(bl->device);
+    bl->device = NULL;
     if (!((bl->name = udev_device_get_sysname(dev)) &&
         (bl->subsystem = udev_device_get_subsystem(dev)) &&
-        (bl->sys_path = get_sys_path(bl->subsystem, bl->name)) &&
         (bl->dev_path = udev_device_get_devpath(dev))))
         return FALSE;
+    if (!bl->sys_path)
+        bl->sys_path = get_sys_path(bl->subsystem, bl->name);
     bl->device = udev_device_ref(dev);
     bl->brightness = get_uint_sysattr(bl, "brightness");
     bl->max_brightness = get_uint_sysattr(bl, "max_brightness");
 
+    if (!bl->levels || max != bl->max_brightness)
+        build_levels(bl);
+
     return TRUE;
 }
 
 static struct Backlight *
-new_backlight(struct udev_device *dev)
+new_backlight(struct udev *udev, struct udev_device *dev)
 {
-    struct Backlight *bl = g_malloc(sizeof(struct Backlight));
+    struct Backlight *bl = g_malloc0(sizeof(struct Backlight));
 
-    bl->device = NULL;
+    bl->udev = udev;
     bl->online = TRUE;
+    bl->max_brightness = -1;
     bl->pre_dim_brightness = -1;
+    default_curve(udev_device_get_subsystem(dev), &bl->curve, &bl->gamma);
     if (!update_backlight(bl, dev)) {
+        g_free(bl->sys_path);
         g_free(bl);
         return NULL;
     }
@@ -92,14 +146,138 @@ new_backlight(struct udev_device *dev)
     return bl;
 }
 
+/* Create a backlight from its class directory entry alone. Name, subsystem
+ * and device path are known without touching udev; the device and its
+ * sysattrs are resolved later by backlight_resolve. */
+static struct Backlight *
+new_lazy_backlight(struct udev *udev, const char *subsystem, const char *name)
+{
+    gchar *sys_path = get_sys_path(subsystem, name);
+    char *real = realpath(sys_path, NULL);
+
+    if (!real) {
+        g_free(sys_path);
+        return NULL;
+    }
+
+    struct Backlight *bl = g_malloc0(sizeof(struct Backlight));
+
+    bl->udev = udev;
+    bl->syspath = g_strdup(real);
+    bl->sys_path = sys_path;
+    bl->name = strrchr(bl->sys_path, '/') + 1;
+    bl->subsystem = subsystem;
+    bl->dev_path = bl->syspath + strlen("/sys");
+    bl->online = TRUE;
+    bl->brightness = -1;
+    bl->max_brightness = -1;
+    bl->pre_dim_brightness = -1;
+    default_curve(subsystem, &bl->curve, &bl->gamma);
+
+    free(real);
+
+    return bl;
+}
+
 static void
 free_backlight(struct Backlight *bl)
 {
-    udev_device_unref(bl->device);
+    if (bl->device)
+        udev_device_unref(bl->device);
+    g_free(bl->syspath);
     g_free(bl->sys_path);
+    g_free(bl->levels);
     g_free(bl);
 }
 
+gboolean
+backlight_resolve(struct Backlight *bl)
+{
+    if (bl->device)
+        return TRUE;
+
+    struct udev_device *dev = udev_device_new_from_syspath(bl->udev,
+            bl->syspath);
+
+    if (!dev) {
+        g_warning("Failed to resolve backlight: %s", bl->sys_path);
+        return FALSE;
+    }
+
+    gboolean ret = update_backlight(bl, dev);
+    udev_device_unref(dev);
+
+    return ret;
+}
+
+void
+backlight_configure(struct Backlight *bl, const Config *c)
+{
+    struct BacklightConf *conf = NULL;
+    BacklightCurve curve;
+    gdouble gamma;
+
+    if (c->backlights)
+        conf = g_hash_table_lookup(c->backlights, bl->sys_path);
+
+    if (conf) {
+        curve = conf->curve;
+        gamma = conf->gamma;
+    } else {
+        default_curve(bl->subsystem, &curve, &gamma);
+    }
+
+    if (curve == bl->curve && gamma == bl->gamma)
+        return;
+
+    bl->curve = curve;
+    bl->gamma = gamma;
+
+    if (bl->levels)
+        build_levels(bl);
+}
+
+gint32
+backlight_percent_to_brightness(struct Backlight *bl, gdouble p)
+{
+    if (!backlight_resolve(bl) || !bl->levels)
+        return -1;
+
+    gdouble x = CLAMP(p, 0.0, 1.0) * BL_LEVELS;
+    guint i = MIN((guint)x, BL_LEVELS - 1);
+    gdouble a = bl->levels[i];
+    gdouble b = bl->levels[i + 1];
+
+    return a + (b - a) * (x - i) + 0.5;
+}
+
+gdouble
+backlight_brightness_to_percent(struct Backlight *bl, gint32 v)
+{
+    if (!backlight_resolve(bl) || !bl->levels || v < 0)
+        return -1;
+
+    if ((guint32)v >= bl->levels[BL_LEVELS])
+        return 1.0;
+
+    /* levels[lo] <= v < levels[hi] */
+    guint lo = 0;
+    guint hi = BL_LEVELS;
+
+    while (hi - lo > 1) {
+        guint mid = (lo + hi) / 2;
+        if (bl->levels[mid] <= (guint32)v)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    gdouble a = bl->levels[lo];
+    gdouble b = bl->levels[hi];
+
+    return (lo + (v - a) / (b - a)) / BL_LEVELS;
+}
+
 static BacklightAction
 get_action(struct udev_device *dev)
 {
@@ -163,9 +341,12 @@ source_dispatch(GSource *source, GSourceFunc func, UNUSED gpointer user_data)
 
     switch (action) {
         case BL_ACTION_ADD:
-            bl = new_backlight(dev);
-            if (!bl || !g_hash_table_insert(self->devices, (char *)sys_path, bl))
+            if (g_hash_table_contains(self->devices, sys_path))
+                goto end;
+            bl = new_backlight(self->udev, dev);
+            if (!bl)
                 goto end;
+            g_hash_table_insert(self->devices, bl->sys_path, bl);
             break;
         case BL_ACTION_REMOVE:
             if (!g_hash_table_remove(self->devices, sys_path))
@@ -204,6 +385,11 @@ source_finalize(GSource *source)
 {
     Backlights *self = (Backlights *)source;
 
+    if (self->resolver) {
+        g_source_destroy(self->resolver);
+        g_source_unref(self->resolver);
+    }
+    g_queue_free_full(self->unresolved, g_free);
     g_queue_free_full(self->queue, (GDestroyNotify)udev_device_unref);
     g_hash_table_unref(self->devices);
     udev_monitor_unref(self->udev_mon);
@@ -219,88 +405,225 @@ static GSourceFuncs source_funcs = {
     NULL,
 };
 
+/* Resolve one pending device per idle dispatch so startup never blocks on
+ * sysattr reads. */
+static gboolean
+resolve_idle(gpointer user_data)
+{
+    Backlights *self = user_data;
+    gchar *path = g_queue_pop_head(self->unresolved);
+
+    if (path) {
+        struct Backlight *bl = g_hash_table_lookup(self->devices, path);
+        if (bl && backlight_resolve(bl))
+            self->func(BL_ACTION_CHANGE, path, bl);
+        g_free(path);
+    }
+
+    if (!g_queue_is_empty(self->unresolved))
+        return G_SOURCE_CONTINUE;
+
+    g_source_unref(self->resolver);
+    self->resolver = NULL;
+    return G_SOURCE_REMOVE;
+}
+
 static void
-backlights_init_devices(Backlights *self, BacklightsFunc func)
+backlights_scan_subsystem(Backlights *self, const char *subsystem)
 {
-    struct udev_enumerate *e = udev_enumerate_new(self->udev);
+    gchar *path = g_strjoin("/", "", "sys", "class", subsystem, NULL);
+    GDir *dir = g_dir_open(path, 0, NULL);
+    const gchar *name;
+
+    g_free(path);
 
-    udev_enumerate_add_match_subsystem(e, "backlight");
-    udev_enumerate_add_match_subsystem(e, "leds");
-    udev_enumerate_scan_devices(e);
+    if (!dir)
+        return;
 
-    struct udev_list_entry *devs = udev_enumerate_get_list_entry(e);
-    struct udev_list_entry *entry;
+    while ((name = g_dir_read_name(dir))) {
+        if (g_strcmp0(subsystem, "leds") == 0
+                && !g_str_has_suffix(name, "::kbd_backlight"))
+            continue;
 
-    udev_list_entry_foreach(entry, devs) {
-        const char *name = udev_list_entry_get_name(entry);
-        struct udev_device *dev = udev_device_new_from_syspath(self->udev,
-                name);
+        struct Backlight *bl = new_lazy_backlight(self->udev, subsystem, name);
 
-        if (!device_is_backlight(dev))
+        if (!bl)
             continue;
 
-        struct Backlight *bl = new_backlight(dev);
-        udev_device_unref(dev);
+        if (g_hash_table_contains(self->devices, bl->sys_path)) {
+            free_backlight(bl);
+            continue;
+        }
+
+        g_hash_table_insert(self->devices, bl->sys_path, bl);
 
-        if (g_hash_table_insert(self->devices, (char *)bl->sys_path, bl))
-            func(BL_ACTION_ADD, bl->sys_path, bl);
+        g_queue_push_tail(self->unresolved, g_strdup(bl->sys_path));
+        self->func(BL_ACTION_ADD, bl->sys_path, bl);
     }
 
-    udev_enumerate_unref(e);
+    g_dir_close(dir);
+}
+
+static void
+backlights_init_devices(Backlights *self, GMainContext *ctx)
+{
+    backlights_scan_subsystem(self, "backlight");
+    backlights_scan_subsystem(self, "leds");
+
+    if (g_queue_is_empty(self->unresolved))
+        return;
+
+    self->resolver = g_idle_source_new();
+    g_source_set_priority(self->resolver, G_PRIORITY_LOW);
+    g_source_set_callback(self->resolver, resolve_idle, self, NULL);
+    g_source_attach(self->resolver, ctx);
+}
+
+static GPtrArray *
+sysfs_batch_new(void)
+{
+    GPtrArray *argv = g_ptr_array_new_with_free_func(g_free);
+    g_ptr_array_add(argv, g_strdup(SYSFS_WRITER));
+    return argv;
 }
 
+static void
+sysfs_batch_add(GPtrArray *argv, const gchar *sys_path, guint32 v)
+{
+    g_ptr_array_add(argv, g_strjoin("/", sys_path, "brightness", NULL));
+    g_ptr_array_add(argv, g_strdup_printf("%u", v));
+}
+
+/* Write every queued PATH VALUE pair with a single helper invocation. */
 static gboolean
-set_backlight_brightness(struct Backlight *bl, guint32 v)
+sysfs_batch_run(GPtrArray *argv)
 {
+    if (argv->len == 1)
+        return TRUE;
+
 #ifndef BACKLIGHT_HELPER
     return FALSE;
 #endif
 
-    if (bl->max_brightness == -1)
+    g_ptr_array_add(argv, NULL);
+
+    if (spawn_exec((gchar **)argv->pdata) != 0)
         return FALSE;
 
-    v = MIN(v, bl->max_brightness);
+    for (guint i = 1; i + 1 < argv->len; i += 2)
+        g_debug("Set %s: %s", (gchar *)g_ptr_array_index(argv, i),
+                (gchar *)g_ptr_array_index(argv, i + 1));
 
-    gchar *str = g_strdup_printf("%u", v);
-    gchar *brightness = g_strjoin("/", bl->sys_path, "brightness", NULL);
-    gchar *argv[] = {SYSFS_WRITER, brightness, str, NULL};
+    return TRUE;
+}
 
-    if (spawn_exec(argv) == 0)
-        g_debug("Set %s brightness: %u", bl->sys_path, v);
+static gboolean
+set_backlight_brightness(struct Backlight *bl, guint32 v)
+{
+    if (!backlight_resolve(bl) || bl->max_brightness == -1)
+        return FALSE;
 
-    g_free(brightness);
-    g_free(str);
+    GPtrArray *argv = sysfs_batch_new();
+    sysfs_batch_add(argv, bl->sys_path, MIN(v, bl->max_brightness));
+    gboolean ret = sysfs_batch_run(argv);
+    g_ptr_array_unref(argv);
 
-    return TRUE;
+    return ret;
 }
 
+typedef struct {
+    guint pending;
+    gboolean success;
+    GPtrArray *sysfs;
+    BacklightsDoneFunc func;
+    gpointer user_data;
+} BacklightBatch;
+
+typedef struct {
+    BacklightBatch *batch;
+    gchar *sys_path;
+    guint32 value;
+} BacklightBatchWrite;
+
 static void
-backlight_dim_value(struct Backlight *bl, guint32 v, LogindContext *ctx)
+batch_write_done(BacklightBatch *b, gboolean success)
 {
-    bl->pre_dim_brightness = bl->brightness;
-    backlight_set_brightness(bl, v, ctx);
+    if (!success)
+        b->success = FALSE;
+
+    if (--b->pending)
+        return;
+
+    /* Writes logind could not make fall back to the helper all at once. */
+    if (!sysfs_batch_run(b->sysfs))
+        b->success = FALSE;
+
+    if (b->func)
+        b->func(b->success, b->user_data);
+    g_ptr_array_unref(b->sysfs);
+    g_free(b);
 }
 
 static void
-backlight_dim_percent(struct Backlight *bl, gdouble percent, LogindContext *ctx)
+on_logind_brightness_set(UNUSED GObject *source, GAsyncResult *res,
+        gpointer user_data)
+{
+    BacklightBatchWrite *w = user_data;
+
+    if (!logind_set_brightness_finish(res))
+        sysfs_batch_add(w->batch->sysfs, w->sys_path, w->value);
+
+    batch_write_done(w->batch, TRUE);
+    g_free(w->sys_path);
+    g_free(w);
+}
+
+static void
+backlight_dim_value(struct Backlight *bl, guint32 v, GArray *writes)
+{
+    if (bl->pre_dim_brightness == -1)
+        bl->pre_dim_brightness = bl->brightness;
+    struct BacklightWrite w = {bl, v};
+    g_array_append_val(writes, w);
+}
+
+static void
+backlight_dim_percent(struct Backlight *bl, gdouble percent, GArray *writes)
 {
     gint32 v = bl->brightness;
     if (v == -1)
         return;
-    bl->pre_dim_brightness = v;
+    if (bl->pre_dim_brightness == -1)
+        bl->pre_dim_brightness = v;
     gdouble d = v - v * percent;
-    backlight_set_brightness(bl, (guint32)(d > 0 ? d + 0.5 : d), ctx);
+    struct BacklightWrite w = {bl, (guint32)(d > 0 ? d + 0.5 : d)};
+    g_array_append_val(writes, w);
 }
 
 static void
-backlight_restore(struct Backlight *bl, LogindContext *ctx)
+backlight_restore(struct Backlight *bl, GArray *writes)
 {
     if (bl->pre_dim_brightness == -1)
         return;
-    backlight_set_brightness(bl, bl->pre_dim_brightness, ctx);
+    struct BacklightWrite w = {bl, bl->pre_dim_brightness};
+    g_array_append_val(writes, w);
     bl->pre_dim_brightness = -1;
 }
 
+static void
+backlight_on_timeout(struct Backlight *bl, const struct BacklightConf *c,
+        gdouble scale, gboolean state, GArray *writes)
+{
+    if (!backlight_resolve(bl))
+        return;
+    if (!state)
+        backlight_restore(bl, writes);
+    else if (c->dim_value != -1)
+        backlight_dim_value(bl, c->dim_value * scale + 0.5, writes);
+    else
+        backlight_dim_percent(bl, c->dim_percent, writes);
+}
+
 Backlights *
 backlights_new(GMainContext *ctx, BacklightsFunc func)
 {
@@ -319,8 +642,11 @@ backlights_new(GMainContext *ctx, BacklightsFunc func)
     self->queue = g_queue_new();
     self->devices = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
             (GDestroyNotify)free_backlight);
+    self->func = func;
+    self->unresolved = g_queue_new();
+    self->resolver = NULL;
 
-    backlights_init_devices(self, func);
+    backlights_init_devices(self, ctx);
 
     self->fd = g_source_add_unix_fd(source,
             udev_monitor_get_fd(self->udev_mon), G_IO_IN);
@@ -344,12 +670,31 @@ backlights_free(Backlights *bls)
 void
 backlights_restore(GHashTable *devs, LogindContext *ctx)
 {
+    GArray *writes = g_array_new(FALSE, FALSE, sizeof(struct BacklightWrite));
+    GPtrArray *argv = sysfs_batch_new();
     GHashTableIter iter;
     gpointer bl;
 
     g_hash_table_iter_init(&iter, devs);
     while (g_hash_table_iter_next(&iter, NULL, &bl))
-        backlight_restore(bl, ctx);
+        backlight_restore(bl, writes);
+
+    for (guint i = 0; i < writes->len; i++) {
+        struct BacklightWrite *w = &g_array_index(writes, struct BacklightWrite,
+                i);
+        struct Backlight *b = w->bl;
+
+        if (b->max_brightness == -1
+                || logind_set_brightness(ctx, b->subsystem, b->name, w->value))
+            continue;
+
+        sysfs_batch_add(argv, b->sys_path, MIN(w->value, b->max_brightness));
+    }
+
+    sysfs_batch_run(argv);
+
+    g_ptr_array_unref(argv);
+    g_array_unref(writes);
 }
 
 gchar *
@@ -371,33 +716,139 @@ backlight_set_brightness(struct Backlight *bl, guint32 v, LogindContext *ctx)
     return TRUE;
 }
 
+/* Issue all writes at once and call func when every one has completed. */
 void
-backlights_on_timeout(GHashTable *devs, GHashTable *cs, guint timeout,
-        gboolean state, LogindContext *ctx)
+backlights_set_brightness_async(GArray *writes, LogindContext *ctx,
+        BacklightsDoneFunc func, gpointer user_data)
+{
+    BacklightBatch *b = g_malloc0(sizeof(BacklightBatch));
+
+    b->pending = 1;
+    b->success = TRUE;
+    b->sysfs = sysfs_batch_new();
+    b->func = func;
+    b->user_data = user_data;
+
+    for (guint i = 0; i < writes->len; i++) {
+        struct BacklightWrite *w = &g_array_index(writes, struct BacklightWrite,
+                i);
+        struct Backlight *bl = w->bl;
+
+        if (!backlight_resolve(bl) || bl->max_brightness == -1) {
+            b->success = FALSE;
+            continue;
+        }
+
+        BacklightBatchWrite *bw = g_malloc(sizeof(BacklightBatchWrite));
+        bw->batch = b;
+        bw->sys_path = g_strdup(bl->sys_path);
+        bw->value = MIN(w->value, bl->max_brightness);
+        b->pending++;
+
+        if (!logind_set_brightness_async(ctx, bl->subsystem, bl->name,
+                    bw->value, on_logind_brightness_set, bw)) {
+            sysfs_batch_add(b->sysfs, bw->sys_path, bw->value);
+            batch_write_done(b, TRUE);
+            g_free(bw->sys_path);
+            g_free(bw);
+        }
+    }
+
+    batch_write_done(b, TRUE);
+}
+
+/* Each bound dim entry holds a reference on its timeout, so a timeout shared
+ * with the idle timeout, hooks or clients is kept while they need it. */
+static void
+bind_dim(struct BacklightDim *d, struct Backlight *bl, Timeline *tl)
+{
+    if (bl && !d->device)
+        timeline_ref_timeout(tl, d->conf->dim_sec);
+    else if (!bl && d->device)
+        timeline_unref_timeout(tl, d->conf->dim_sec);
+
+    d->device = bl;
+}
+
+/* Bind bl to the dim entries of path, or unbind them if bl is NULL, keeping
+ * the timeline's dim timeouts in step with the devices present. */
+void
+backlights_bind_dims(const Config *c, const gchar *path, struct Backlight *bl,
+        Timeline *tl)
+{
+    if (!c->backlight_dim_paths)
+        return;
+
+    GPtrArray *dims = g_hash_table_lookup(c->backlight_dim_paths, path);
+    if (!dims)
+        return;
+
+    for (guint i = 0; i < dims->len; i++)
+        bind_dim(g_ptr_array_index(dims, i), bl, tl);
+}
+
+void
+backlights_bind_all_dims(const Config *c, GHashTable *devs, Timeline *tl)
 {
     GHashTableIter iter;
     gpointer key, val;
 
-    g_hash_table_iter_init(&iter, cs);
-    while (g_hash_table_iter_next(&iter, &key, &val)) {
-        const char *sys_path = key;
-        struct BacklightConf *c = val;
+    g_hash_table_iter_init(&iter, devs);
+    while (g_hash_table_iter_next(&iter, &key, &val))
+        backlights_bind_dims(c, key, val, tl);
+}
 
-        if (c->dim_sec != timeout)
-            continue;
+/* Release the timeouts held by c's dim entries before it is freed. */
+void
+backlights_unbind_all_dims(const Config *c, Timeline *tl)
+{
+    GHashTableIter iter;
+    gpointer val;
 
-        struct Backlight *bl = g_hash_table_lookup(devs, sys_path);
+    if (!c->backlight_dim_paths)
+        return;
 
-        if (!bl)
-            continue;
+    g_hash_table_iter_init(&iter, c->backlight_dim_paths);
+    while (g_hash_table_iter_next(&iter, NULL, &val)) {
+        GPtrArray *dims = val;
+        for (guint i = 0; i < dims->len; i++)
+            bind_dim(g_ptr_array_index(dims, i), NULL, tl);
+    }
+}
 
-        if (state) {
-            if (c->dim_value != -1)
-                backlight_dim_value(bl, c->dim_value, ctx);
-            else
-                backlight_dim_percent(bl, c->dim_percent, ctx);
-        } else {
-            backlight_restore(bl, ctx);
-        }
+void
+backlights_configure(const Config *c, GHashTable *devs)
+{
+    GHashTableIter iter;
+    gpointer bl;
+
+    g_hash_table_iter_init(&iter, devs);
+    while (g_hash_table_iter_next(&iter, NULL, &bl))
+        backlight_configure(bl, c);
+}
+
+void
+backlights_on_timeout(const Config *c, guint timeout, gboolean state,
+        LogindContext *ctx)
+{
+    if (!c->backlight_dims)
+        return;
+
+    GPtrArray *dims = g_hash_table_lookup(c->backlight_dims,
+            GUINT_TO_POINTER(timeout));
+    if (!dims)
+        return;
+
+    GArray *writes = g_array_new(FALSE, FALSE, sizeof(struct BacklightWrite));
+
+    for (guint i = 0; i < dims->len; i++) {
+        struct BacklightDim *d = g_ptr_array_index(dims, i);
+        if (d->device)
+            backlight_on_timeout(d->device, d->conf, d->scale, state, writes);
     }
+
+    if (writes->len)
+        backlights_set_brightness_async(writes, ctx, NULL, NULL);
+
+    g_array_unref(writes);
 }
@@ -17,11 +17,16 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include "config.h"
 #include "dbus-logind.h"
+#include "timeline.h"
 
 #include <glib-2.0/glib.h>
 #include <libudev.h>
 
+/* Number of steps in a backlight's precomputed brightness curve. */
+#define BL_LEVELS 100
+
 #define BL_ACTION_LIST \
     X(ADD, "add") \
     X(REMOVE, "remove") \
@@ -41,7 +46,9 @@ typedef enum {
 } BacklightType;
 
 struct Backlight {
+    struct udev *udev;
     struct udev_device *device;
+    gchar *syspath;
     const char *name;
     const char *subsystem;
     gchar *sys_path;
@@ -50,10 +57,19 @@ struct Backlight {
     gint32 brightness;
     gint32 max_brightness;
     gint32 pre_dim_brightness;
+    BacklightCurve curve;
+    gdouble gamma;
+    guint32 *levels;
+};
+
+struct BacklightWrite {
+    struct Backlight *bl;
+    guint32 value;
 };
 
 typedef gboolean (*BacklightsFunc)(BacklightAction a, const gchar *path,
         struct Backlight *bl);
+typedef void (*BacklightsDoneFunc)(gboolean success, gpointer user_data);
 
 typedef struct {
     GSource source;
@@ -62,12 +78,23 @@ typedef struct {
     struct udev_monitor *udev_mon;
     GQueue *queue;
     GHashTable *devices;
+    BacklightsFunc func;
+    GQueue *unresolved;
+    GSource *resolver;
 } Backlights;
 
 extern Backlights *
 backlights_new(GMainContext *ctx, BacklightsFunc func);
 extern void
 backlights_free(Backlights *bls);
+extern gboolean
+backlight_resolve(struct Backlight *bl);
+extern void
+backlight_configure(struct Backlight *bl, const Config *c);
+extern gint32
+backlight_percent_to_brightness(struct Backlight *bl, gdouble p);
+extern gdouble
+backlight_brightness_to_percent(struct Backlight *bl, gint32 v);
 extern void
 backlights_restore(GHashTable *devs, LogindContext *ctx);
 extern gchar *
@@ -75,5 +102,17 @@ backlight_normalize_name(const char *name);
 extern gboolean
 backlight_set_brightness(struct Backlight *bl, guint32 v, LogindContext *ctx);
 extern void
-backlights_on_timeout(GHashTable *devs, GHashTable *cs, guint timeout,
-        gboolean state, LogindContext *ctx);
+backlights_set_brightness_async(GArray *writes, LogindContext *ctx,
+        BacklightsDoneFunc func, gpointer user_data);
+extern void
+backlights_bind_dims(const Config *c, const gchar *path, struct Backlight *bl,
+        Timeline *tl);
+extern void
+backlights_bind_all_dims(const Config *c, GHashTable *devs, Timeline *tl);
+extern void
+backlights_unbind_all_dims(const Config *c, Timeline *tl);
+extern void
+backlights_configure(const Config *c, GHashTable *devs);
+extern void
+backlights_on_timeout(const Config *c, guint timeout, gboolean state,
+        LogindContext *ctx);
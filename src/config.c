@@ -52,10 +52,14 @@ new_backlight(const gchar *path)
         bl->dim_sec = 60 * 8;
         bl->dim_value = -1;
         bl->dim_percent = 0.3;
+        bl->curve = BL_CURVE_GAMMA;
+        bl->gamma = 2.2;
     } else if (g_strcmp0(subsystem, "leds") == 0) {
         bl->dim_sec = 60;
         bl->dim_value = 0;
         bl->dim_percent = -1;
+        bl->curve = BL_CURVE_LINEAR;
+        bl->gamma = 2.2;
     } else {
         g_warning("Unrecognized backlight path: %s", path);
         g_free(bl);
@@ -241,6 +245,31 @@ end:
     return 0;
 }
 
+static gint
+load_curve(toml_table_t *tab, const char *key, guint *ret)
+{
+    gchar *str = NULL;
+
+    if (load_str(tab, key, &str) == -1)
+        return -1;
+
+    if (!str)
+        return 0;
+
+#define X(c, n) \
+    if (g_strcmp0(str, n) == 0) { \
+        *ret = BL_CURVE_##c; \
+        g_free(str); \
+        return 0; \
+    }
+    BACKLIGHT_CURVE_LIST
+#undef X
+
+    g_warning("Failed to parse %s: unknown curve: %s", key, str);
+    g_free(str);
+    return -1;
+}
+
 static gint
 load_backlights(toml_table_t *tab, const char *key, GHashTable *out)
 {
@@ -272,17 +301,216 @@ load_backlights(toml_table_t *tab, const char *key, GHashTable *out)
 #define X(key, type, name) \
         load_##type(t, key, &bl->name);
         BACKLIGHT_TABLE_LIST
+        BACKLIGHT_CURVE_TABLE_LIST
 #undef X
 
         if (bl->dim_percent != -1)
             bl->dim_percent = CLAMP(bl->dim_percent, 0.01, 1.0);
 
+        bl->gamma = CLAMP(bl->gamma, 0.1, 10.0);
+
         g_hash_table_insert(out, path, bl);
     }
 
     return 0;
 }
 
+static gboolean
+valid_group_name(const gchar *name)
+{
+    if (!*name)
+        return FALSE;
+
+    for (const gchar *c = name; *c; c++)
+        if (!(g_ascii_isalnum(*c) || *c == '_'))
+            return FALSE;
+
+    return TRUE;
+}
+
+static void
+free_backlight_group(struct BacklightGroupConf *g)
+{
+    if (!g)
+        return;
+    for (guint i = 0; g->members && i < g->members->len; i++)
+        g_free(g_array_index(g->members, struct BacklightGroupMember, i).path);
+    if (g->members)
+        g_array_unref(g->members);
+    g_free(g->name);
+    g_free(g);
+}
+
+static gint
+load_backlight_group(toml_table_t *tab, GHashTable *out, const gchar **err)
+{
+    struct BacklightGroupConf *g = g_malloc0(sizeof(struct BacklightGroupConf));
+
+    g->conf.dim_sec = 0;
+    g->conf.dim_value = -1;
+    g->conf.dim_percent = 0.3;
+    g->members = g_array_new(FALSE, FALSE,
+            sizeof(struct BacklightGroupMember));
+
+    load_str(tab, "Name", &g->name);
+
+    if (!g->name) {
+        *err = "expected Name key";
+        goto err;
+    }
+
+    if (!valid_group_name(g->name)) {
+        *err = "Name must only contain the characters [A-Za-z0-9_]";
+        goto err;
+    }
+
+#define X(key, type, name) \
+    load_##type(tab, key, &g->conf.name);
+    BACKLIGHT_TABLE_LIST
+#undef X
+
+    if (g->conf.dim_percent != -1)
+        g->conf.dim_percent = CLAMP(g->conf.dim_percent, 0.01, 1.0);
+
+    toml_array_t *members = toml_array_in(tab, "Member");
+    int len;
+
+    if (!members || (len = toml_array_nelem(members)) == 0) {
+        *err = "expected at least one [[BacklightGroup.Member]] table";
+        goto err;
+    }
+
+    if (toml_array_kind(members) != 't') {
+        *err = "expected Member to be an array of tables";
+        goto err;
+    }
+
+    for (int i = 0; i < len; i++) {
+        toml_table_t *t = toml_table_at(members, i);
+        struct BacklightGroupMember m = {NULL, 1.0};
+
+        load_str(t, "Path", &m.path);
+
+        if (!m.path) {
+            *err = "expected Path key in Member table";
+            goto err;
+        }
+
+#define X(key, type, name) \
+        load_##type(t, key, &m.name);
+        BACKLIGHT_GROUP_MEMBER_TABLE_LIST
+#undef X
+
+        m.scale = MAX(m.scale, 0.0);
+        g_array_append_val(g->members, m);
+    }
+
+    if (g_hash_table_contains(out, g->name)) {
+        *err = "duplicate Name";
+        goto err;
+    }
+
+    g_hash_table_insert(out, g->name, g);
+    return 0;
+
+err:
+    free_backlight_group(g);
+    return -1;
+}
+
+static gint
+load_backlight_groups(toml_table_t *tab, const char *key, GHashTable *out)
+{
+    int len;
+    toml_array_t *groups = toml_array_in(tab, key);
+
+    if (!groups || (len = toml_array_nelem(groups)) == 0)
+        return 0;
+
+    if (toml_array_kind(groups) != 't') {
+        g_warning("Failed to parse %s: expected array of tables", key);
+        return -1;
+    }
+
+    for (int i = 0; i < len; i++) {
+        const gchar *err;
+        if (load_backlight_group(toml_table_at(groups, i), out, &err) == -1) {
+            g_warning("Failed to parse %s at index %d: %s", key, i, err);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static void
+add_backlight_dim(Config *c, const gchar *path, const struct BacklightConf *conf,
+        gdouble scale)
+{
+    if (!conf->dim_sec)
+        return;
+
+    struct BacklightDim *d = g_malloc(sizeof(struct BacklightDim));
+    d->path = path;
+    d->conf = conf;
+    d->scale = scale;
+    d->device = NULL;
+
+    gpointer key = GUINT_TO_POINTER(conf->dim_sec);
+    GPtrArray *dims = g_hash_table_lookup(c->backlight_dims, key);
+    if (!dims) {
+        dims = g_ptr_array_new_with_free_func(g_free);
+        g_hash_table_insert(c->backlight_dims, key, dims);
+    }
+    g_ptr_array_add(dims, d);
+
+    dims = g_hash_table_lookup(c->backlight_dim_paths, path);
+    if (!dims) {
+        dims = g_ptr_array_new();
+        g_hash_table_insert(c->backlight_dim_paths, (gpointer)path, dims);
+    }
+    g_ptr_array_add(dims, d);
+}
+
+/* Index dimmed devices by timeout and by path so timeouts and hotplug events
+ * only touch the entries they concern. */
+static void
+build_backlight_dims(Config *c)
+{
+    GHashTableIter iter;
+    gpointer key, val;
+
+    c->backlight_dims = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+            NULL, (GDestroyNotify)g_ptr_array_unref);
+    c->backlight_dim_paths = g_hash_table_new_full(g_str_hash, g_str_equal,
+            NULL, (GDestroyNotify)g_ptr_array_unref);
+
+    if (c->backlights) {
+        g_hash_table_iter_init(&iter, c->backlights);
+        while (g_hash_table_iter_next(&iter, &key, &val))
+            add_backlight_dim(c, key, val, 1.0);
+    }
+
+    if (c->backlight_groups) {
+        g_hash_table_iter_init(&iter, c->backlight_groups);
+        while (g_hash_table_iter_next(&iter, NULL, &val)) {
+            struct BacklightGroupConf *g = val;
+            for (guint i = 0; i < g->members->len; i++) {
+                struct BacklightGroupMember *m = &g_array_index(g->members,
+                        struct BacklightGroupMember, i);
+                add_backlight_dim(c, m->path, &g->conf, m->scale);
+            }
+        }
+    }
+
+    if (!g_hash_table_size(c->backlight_dims)) {
+        g_hash_table_unref(c->backlight_dims);
+        g_hash_table_unref(c->backlight_dim_paths);
+        c->backlight_dims = NULL;
+        c->backlight_dim_paths = NULL;
+    }
+}
+
 static gint
 load_trigger(toml_table_t *tab, const char *key, guint *ret)
 {
@@ -427,9 +655,15 @@ config_new(void)
     c.input_mask = INPUT_TYPE_MASK(RawMotion)
         | INPUT_TYPE_MASK(RawButtonPress) | INPUT_TYPE_MASK(RawKeyPress);
     c.idle_sec = 60 * 20;
+    c.inhibit_on_fullscreen = FALSE;
     c.on_idle = TRUE;
     c.on_sleep = TRUE;
+    c.properties_interval_msec = 50;
+    c.broadcast_inactive = TRUE;
     c.backlights = NULL;
+    c.backlight_groups = NULL;
+    c.backlight_dims = NULL;
+    c.backlight_dim_paths = NULL;
     c.hooks = NULL;
 #ifdef DPMS
     c.dpms_enable = TRUE;
@@ -441,6 +675,9 @@ config_new(void)
     c.lock_suspend_sec = 60;
     c.lock_off_sec = 60;
 #endif /* DPMS */
+#ifdef WIREPLUMBER
+    c.inhibit_on_audio = FALSE;
+#endif /* WIREPLUMBER */
 
     return c;
 }
@@ -467,6 +704,10 @@ config_load(const gchar *path, const gchar *hooksd, Config *c)
         LOCK_TABLE_LIST
     }
 
+    if ((tab = toml_table_in(conf, "DBus"))) {
+        DBUS_TABLE_LIST
+    }
+
 #ifdef DPMS
     if ((tab = toml_table_in(conf, "DPMS"))) {
         DPMS_TABLE_LIST
@@ -478,6 +719,10 @@ config_load(const gchar *path, const gchar *hooksd, Config *c)
 #endif /* DPMS */
 
 #ifdef WIREPLUMBER
+    if ((tab = toml_table_in(conf, "Idle"))) {
+        WP_IDLE_TABLE_LIST
+    }
+
     if ((tab = toml_table_in(conf, "Lock"))) {
         WP_LOCK_TABLE_LIST
     }
@@ -495,6 +740,18 @@ config_load(const gchar *path, const gchar *hooksd, Config *c)
         c->backlights = NULL;
     }
 
+    c->backlight_groups = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+            (GDestroyNotify)free_backlight_group);
+
+    ret += load_backlight_groups(conf, "BacklightGroup", c->backlight_groups);
+
+    if (!g_hash_table_size(c->backlight_groups)) {
+        g_hash_table_unref(c->backlight_groups);
+        c->backlight_groups = NULL;
+    }
+
+    build_backlight_dims(c);
+
     c->hooks = g_ptr_array_new_with_free_func((GDestroyNotify)free_hook);
 
     ret += load_hooks(conf, "Hook", c->hooks);
@@ -518,8 +775,14 @@ config_free(Config *c)
     if (!c)
         return;
 
+    if (c->backlight_dims)
+        g_hash_table_unref(c->backlight_dims);
+    if (c->backlight_dim_paths)
+        g_hash_table_unref(c->backlight_dim_paths);
     if (c->backlights)
         g_hash_table_unref(c->backlights);
+    if (c->backlight_groups)
+        g_hash_table_unref(c->backlight_groups);
     if (c->hooks)
         g_ptr_array_free(c->hooks, TRUE);
 }
@@ -21,12 +21,17 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 
 #define IDLE_TABLE_LIST \
     X("Inputs", input_mask, input_mask) \
-    X("IdleSec", uint, idle_sec)
+    X("IdleSec", uint, idle_sec) \
+    X("InhibitOnFullscreen", bool, inhibit_on_fullscreen)
 
 #define LOCK_TABLE_LIST \
     X("OnIdle", bool, on_idle) \
     X("OnSleep", bool, on_sleep)
 
+#define DBUS_TABLE_LIST \
+    X("PropertiesIntervalMsec", uint, properties_interval_msec) \
+    X("BroadcastInactive", bool, broadcast_inactive)
+
 #define BACKLIGHT_TABLE_LIST \
     X("DimSec", uint, dim_sec) \
     X("DimValue", int, dim_value) \
@@ -46,25 +51,76 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 #endif /* DPMS */
 
 #ifdef WIREPLUMBER
+#define WP_IDLE_TABLE_LIST \
+    X("InhibitOnAudio", bool, inhibit_on_audio)
+
 #define WP_LOCK_TABLE_LIST \
     X("MuteAudio", bool, mute_audio)
 #endif /* WIREPLUMBER */
 
+#define BACKLIGHT_CURVE_TABLE_LIST \
+    X("Curve", curve, curve) \
+    X("Gamma", double, gamma)
+
+#define BACKLIGHT_CURVE_LIST \
+    X(LINEAR, "linear") \
+    X(GAMMA, "gamma") \
+    X(LOG, "log")
+
+typedef enum {
+#define X(curve, _) BL_CURVE_##curve,
+    BACKLIGHT_CURVE_LIST
+#undef X
+} BacklightCurve;
+
+#define BACKLIGHT_GROUP_MEMBER_TABLE_LIST \
+    X("Scale", double, scale)
+
+struct Backlight;
+
 struct BacklightConf {
     guint dim_sec;
     gint dim_value;
     gdouble dim_percent;
+    guint curve;
+    gdouble gamma;
+};
+
+struct BacklightGroupMember {
+    gchar *path;
+    gdouble scale;
+};
+
+struct BacklightGroupConf {
+    gchar *name;
+    struct BacklightConf conf;
+    GArray *members;
+};
+
+/* A device dimmed at conf->dim_sec; device is bound while it is present. */
+struct BacklightDim {
+    const gchar *path;
+    const struct BacklightConf *conf;
+    gdouble scale;
+    struct Backlight *device;
 };
 
 typedef struct {
     /* Idle */
     guint input_mask;
     guint idle_sec;
+    gboolean inhibit_on_fullscreen;
     /* Lock */
     gboolean on_idle;
     gboolean on_sleep;
+    /* DBus */
+    guint properties_interval_msec;
+    gboolean broadcast_inactive;
     /* Backlights */
     GHashTable *backlights;
+    GHashTable *backlight_groups;
+    GHashTable *backlight_dims;
+    GHashTable *backlight_dim_paths;
     /* Hooks */
     GPtrArray *hooks;
 #ifdef DPMS
@@ -80,6 +136,7 @@ typedef struct {
 #endif /* DPMS */
 #ifdef WIREPLUMBER
     /* WIREPLUMBER */
+    gboolean inhibit_on_audio;
     gboolean mute_audio;
 #endif /* WIREPLUMBER */
 } Config;
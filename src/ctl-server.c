@@ -0,0 +1,486 @@
+/*
+sessiond - standalone X session manager
+Copyright (C) 2018-2020 James Reed
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#define G_LOG_DOMAIN "sessiond"
+
+#include "ctl-server.h"
+#include "dbus-server.h"
+#include "dbus-gen.h"
+#include "json.h"
+#include "common.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <glib-2.0/glib.h>
+#include <glib-2.0/glib/gstdio.h>
+#include <glib-2.0/gio/gio.h>
+#include <gio/gunixsocketaddress.h>
+
+#define CTL_MAX_LINE 65536
+
+#define ERROR_FAILED "org.freedesktop.DBus.Error.Failed"
+#define ERROR_INVALID_ARGS "org.freedesktop.DBus.Error.InvalidArgs"
+#define ERROR_UNKNOWN_METHOD "org.freedesktop.DBus.Error.UnknownMethod"
+#define ERROR_NOT_SUPPORTED "org.freedesktop.DBus.Error.NotSupported"
+
+static GDBusInterfaceInfo *(*interfaces[])(void) = {
+    dbus_session_interface_info,
+    dbus_backlight_interface_info,
+    dbus_backlight_group_interface_info,
+    dbus_audio_sink_interface_info,
+    NULL,
+};
+
+typedef struct {
+    CtlServer *s;
+    GSocketConnection *conn;
+    GDataInputStream *in;
+    GOutputStream *out;
+    GCancellable *cancellable;
+    gchar *reply;
+    gchar *path;
+    gchar *iface;
+    GDBusMethodInfo *method;
+    GVariant *params;
+} CtlClient;
+
+static void
+read_request(CtlClient *c);
+
+static void
+clear_request(CtlClient *c)
+{
+    g_clear_pointer(&c->path, g_free);
+    g_clear_pointer(&c->iface, g_free);
+    g_clear_pointer(&c->params, g_variant_unref);
+    c->method = NULL;
+}
+
+static void
+free_client(CtlClient *c)
+{
+    clear_request(c);
+    g_free(c->reply);
+    g_object_unref(c->in);
+    g_io_stream_close(G_IO_STREAM(c->conn), NULL, NULL);
+    g_object_unref(c->conn);
+    g_object_unref(c->cancellable);
+    g_free(c);
+}
+
+static void
+on_written(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    CtlClient *c = (CtlClient *)user_data;
+    GError *err = NULL;
+
+    g_output_stream_write_all_finish(G_OUTPUT_STREAM(source), res, NULL,
+            &err);
+    g_clear_pointer(&c->reply, g_free);
+
+    if (err) {
+        if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            g_debug("Failed to write reply: %s", err->message);
+        g_error_free(err);
+        free_client(c);
+        return;
+    }
+
+    read_request(c);
+}
+
+/* Replies are a single JSON object: {"parameters": [...]} on success, or
+ * {"error": name, "message": message} using DBus error names. */
+static void
+write_reply(CtlClient *c, GVariant *reply)
+{
+    GString *out = g_string_new(NULL);
+
+    json_append(out, reply);
+    g_string_append_c(out, '\n');
+    g_variant_unref(g_variant_ref_sink(reply));
+
+    clear_request(c);
+    c->reply = g_string_free(out, FALSE);
+
+    g_output_stream_write_all_async(c->out, c->reply, strlen(c->reply),
+            G_PRIORITY_DEFAULT, c->cancellable, on_written, c);
+}
+
+static void
+reply_error(CtlClient *c, const gchar *name, const gchar *msg)
+{
+    GVariantBuilder b;
+
+    g_variant_builder_init(&b, G_VARIANT_TYPE("a{ss}"));
+    g_variant_builder_add(&b, "{ss}", "error", name);
+    g_variant_builder_add(&b, "{ss}", "message", msg);
+
+    write_reply(c, g_variant_builder_end(&b));
+}
+
+static void
+on_call_done(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    CtlClient *c = (CtlClient *)user_data;
+    GError *err = NULL;
+    GVariant *ret = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source),
+            res, &err);
+
+    if (g_cancellable_is_cancelled(c->cancellable)) {
+        g_clear_error(&err);
+        g_clear_pointer(&ret, g_variant_unref);
+        free_client(c);
+        return;
+    }
+
+    if (err) {
+        gchar *name = g_dbus_error_get_remote_error(err);
+        g_dbus_error_strip_remote_error(err);
+        reply_error(c, name ? name : ERROR_FAILED, err->message);
+        g_free(name);
+        g_error_free(err);
+        return;
+    }
+
+    GVariantBuilder b;
+
+    g_variant_builder_init(&b, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add(&b, "{sv}", "parameters", ret);
+    g_variant_unref(ret);
+
+    write_reply(c, g_variant_builder_end(&b));
+}
+
+static void
+call(CtlClient *c)
+{
+    g_dbus_connection_call(c->s->conn, NULL, c->path, c->iface,
+            c->method->name, c->params, NULL, G_DBUS_CALL_FLAGS_NONE, -1,
+            c->cancellable, on_call_done, c);
+}
+
+static void
+on_connected(UNUSED GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    GError *err = NULL;
+    GDBusConnection *conn = g_dbus_connection_new_for_address_finish(res,
+            &err);
+
+    if (g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        g_error_free(err);
+        return;
+    }
+
+    CtlServer *s = (CtlServer *)user_data;
+    CtlClient *c;
+
+    s->connecting = FALSE;
+    s->conn = conn;
+
+    if (err)
+        g_warning("Failed to connect to %s: %s", s->address, err->message);
+
+    while ((c = g_queue_pop_head(&s->waiting))) {
+        if (err)
+            reply_error(c, ERROR_FAILED, err->message);
+        else
+            call(c);
+    }
+
+    g_clear_error(&err);
+}
+
+/* The connection is made on the first request and again after it closes. */
+static void
+with_connection(CtlClient *c)
+{
+    CtlServer *s = c->s;
+
+    if (s->conn && !g_dbus_connection_is_closed(s->conn)) {
+        call(c);
+        return;
+    }
+
+    g_queue_push_tail(&s->waiting, c);
+
+    if (s->connecting)
+        return;
+
+    g_clear_object(&s->conn);
+    s->connecting = TRUE;
+    g_dbus_connection_new_for_address(s->address,
+            G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT, NULL,
+            s->cancellable, on_connected, s);
+}
+
+/* Methods are named by interface relative to the service, e.g.
+ * "Backlight.IncBrightness". */
+static GDBusMethodInfo *
+lookup_method(const gchar *name, gchar **iface)
+{
+    const gchar *dot = strrchr(name, '.');
+
+    if (!dot)
+        return NULL;
+
+    gchar *iname = g_strdup_printf(DBUS_NAME ".%.*s", (gint)(dot - name),
+            name);
+
+    for (guint i = 0; interfaces[i]; i++) {
+        GDBusInterfaceInfo *info = interfaces[i]();
+        GDBusMethodInfo *m;
+
+        if (g_strcmp0(info->name, iname) != 0)
+            continue;
+
+        m = g_dbus_interface_info_lookup_method(info, dot + 1);
+        if (m) {
+            *iface = iname;
+            return m;
+        }
+        break;
+    }
+
+    g_free(iname);
+
+    return NULL;
+}
+
+static gboolean
+args_have_fds(GDBusArgInfo **args)
+{
+    for (guint i = 0; args && args[i]; i++)
+        if (strchr(args[i]->signature, 'h'))
+            return TRUE;
+
+    return FALSE;
+}
+
+static GVariantType *
+args_type(GDBusArgInfo **args)
+{
+    GString *str = g_string_new("(");
+
+    for (guint i = 0; args && args[i]; i++)
+        g_string_append(str, args[i]->signature);
+    g_string_append_c(str, ')');
+
+    GVariantType *type = g_variant_type_new(str->str);
+    g_string_free(str, TRUE);
+
+    return type;
+}
+
+/* A request is an object with a "method", an optional object "path",
+ * absolute or relative to the service's path, and optional "parameters",
+ * an array converted to the method's argument types. */
+static void
+handle_request(CtlClient *c, const gchar *line)
+{
+    GError *err = NULL;
+    GVariant *req = json_parse(line, &err);
+    const gchar *name, *path = NULL;
+    GVariant *params;
+
+    if (!req || !g_variant_is_of_type(req, G_VARIANT_TYPE_VARDICT)
+            || !g_variant_lookup(req, "method", "&s", &name)) {
+        reply_error(c, ERROR_INVALID_ARGS,
+                err ? err->message : "Expected an object with a method");
+        g_clear_error(&err);
+        g_clear_pointer(&req, g_variant_unref);
+        return;
+    }
+
+    c->method = lookup_method(name, &c->iface);
+    if (!c->method) {
+        gchar *msg = g_strdup_printf("Unknown method %s", name);
+        reply_error(c, ERROR_UNKNOWN_METHOD, msg);
+        g_free(msg);
+        g_variant_unref(req);
+        return;
+    }
+
+    if (args_have_fds(c->method->in_args)
+            || args_have_fds(c->method->out_args)) {
+        reply_error(c, ERROR_NOT_SUPPORTED,
+                "Methods passing file descriptors are not supported");
+        g_variant_unref(req);
+        return;
+    }
+
+    g_variant_lookup(req, "path", "&s", &path);
+    if (!path)
+        c->path = g_strdup(DBUS_PATH);
+    else if (*path == '/')
+        c->path = g_strdup(path);
+    else
+        c->path = g_strconcat(DBUS_PATH "/", path, NULL);
+
+    if (!g_variant_is_object_path(c->path)) {
+        reply_error(c, ERROR_INVALID_ARGS, "Invalid object path");
+        g_variant_unref(req);
+        return;
+    }
+
+    params = g_variant_lookup_value(req, "parameters", NULL);
+    if (!params)
+        params = g_variant_ref_sink(g_variant_new("av", NULL));
+
+    GVariantType *type = args_type(c->method->in_args);
+    GVariant *conv = json_convert(params, type, &err);
+
+    g_variant_type_free(type);
+    g_variant_unref(params);
+    g_variant_unref(req);
+
+    if (!conv) {
+        reply_error(c, ERROR_INVALID_ARGS, err->message);
+        g_error_free(err);
+        return;
+    }
+
+    c->params = g_variant_ref_sink(conv);
+    with_connection(c);
+}
+
+static void
+on_read_line(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    CtlClient *c = (CtlClient *)user_data;
+    GError *err = NULL;
+    gsize len;
+    gchar *line = g_data_input_stream_read_line_finish(
+            G_DATA_INPUT_STREAM(source), res, &len, &err);
+
+    if (!line || g_cancellable_is_cancelled(c->cancellable)
+            || len > CTL_MAX_LINE) {
+        if (err && !g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            g_debug("Failed to read request: %s", err->message);
+        g_clear_error(&err);
+        g_free(line);
+        free_client(c);
+        return;
+    }
+
+    if (*g_strstrip(line))
+        handle_request(c, line);
+    else
+        read_request(c);
+
+    g_free(line);
+}
+
+static void
+read_request(CtlClient *c)
+{
+    g_data_input_stream_read_line_async(c->in, G_PRIORITY_DEFAULT,
+            c->cancellable, on_read_line, c);
+}
+
+static gboolean
+on_incoming(UNUSED GSocketService *service, GSocketConnection *conn,
+        UNUSED GObject *source, gpointer user_data)
+{
+    CtlServer *s = (CtlServer *)user_data;
+    GCredentials *creds = g_socket_get_credentials(
+            g_socket_connection_get_socket(conn), NULL);
+    gboolean allowed = creds
+        && g_credentials_get_unix_user(creds, NULL) == getuid();
+
+    g_clear_object(&creds);
+
+    if (!allowed) {
+        g_debug("Rejected request connection from another user");
+        return TRUE;
+    }
+
+    CtlClient *c = g_malloc0(sizeof(CtlClient));
+    c->s = s;
+    c->conn = g_object_ref(conn);
+    c->in = g_data_input_stream_new(
+            g_io_stream_get_input_stream(G_IO_STREAM(conn)));
+    c->out = g_io_stream_get_output_stream(G_IO_STREAM(conn));
+    c->cancellable = g_object_ref(s->cancellable);
+
+    g_data_input_stream_set_newline_type(c->in,
+            G_DATA_STREAM_NEWLINE_TYPE_LF);
+    read_request(c);
+
+    return TRUE;
+}
+
+CtlServer *
+ctl_server_new(const gchar *path, const gchar *address)
+{
+    GSocketService *service = g_socket_service_new();
+    GSocketAddress *addr = g_unix_socket_address_new(path);
+    GError *err = NULL;
+
+    g_unlink(path);
+    g_socket_listener_add_address(G_SOCKET_LISTENER(service), addr,
+            G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT, NULL, NULL, &err);
+    g_object_unref(addr);
+
+    if (err) {
+        g_warning("Failed to listen on %s: %s", path, err->message);
+        g_error_free(err);
+        g_object_unref(service);
+        return NULL;
+    }
+
+    CtlServer *s = g_malloc(sizeof(CtlServer));
+    s->service = service;
+    s->path = g_strdup(path);
+    s->address = g_strdup(address);
+    s->conn = NULL;
+    s->connecting = FALSE;
+    g_queue_init(&s->waiting);
+    s->cancellable = g_cancellable_new();
+
+    g_signal_connect(service, "incoming", G_CALLBACK(on_incoming), s);
+    g_socket_service_start(service);
+
+    g_debug("Listening for requests on %s", path);
+
+    return s;
+}
+
+/* Clients with a request in progress are freed when it is cancelled. */
+void
+ctl_server_free(CtlServer *s)
+{
+    CtlClient *c;
+
+    if (!s)
+        return;
+
+    g_cancellable_cancel(s->cancellable);
+    g_socket_service_stop(s->service);
+    g_socket_listener_close(G_SOCKET_LISTENER(s->service));
+    g_object_unref(s->service);
+    g_unlink(s->path);
+
+    while ((c = g_queue_pop_head(&s->waiting)))
+        free_client(c);
+
+    g_clear_object(&s->conn);
+    g_object_unref(s->cancellable);
+    g_free(s->address);
+    g_free(s->path);
+    g_free(s);
+}
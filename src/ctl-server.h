@@ -0,0 +1,41 @@
+/*
+sessiond - standalone X session manager
+Copyright (C) 2018-2020 James Reed
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <glib-2.0/glib.h>
+#include <glib-2.0/gio/gio.h>
+
+#define CTL_SOCKET "sessiond/ctl"
+
+/* Serves line-delimited JSON requests on a unix socket, forwarding each as a
+ * method call to the DBus server at address. Requests from a client are
+ * handled in order, one at a time. */
+typedef struct {
+    GSocketService *service;
+    gchar *path;
+    gchar *address;
+    GDBusConnection *conn;
+    gboolean connecting;
+    GQueue waiting;
+    GCancellable *cancellable;
+} CtlServer;
+
+extern CtlServer *
+ctl_server_new(const gchar *path, const gchar *address);
+extern void
+ctl_server_free(CtlServer *s);
@@ -38,20 +38,25 @@ set_default_audio_sink_property(DBusServer *s, DBusAudioSink *das)
 static void
 set_audio_sinks_property(DBusServer *s)
 {
-    GList *dass = g_hash_table_get_values(s->audiosinks);
-    const gchar **paths = g_malloc0_n(g_list_length(dass) + 1, sizeof(gchar *));
-
-    guint n = 0;
-    for (GList *i = dass; i; i = i->next, n++) {
-        DBusAudioSink *das = i->data;
-        const gchar *path = g_dbus_interface_skeleton_get_object_path(
-                G_DBUS_INTERFACE_SKELETON(das));
-        if (path)
-            paths[n] = path;
-    }
+    if (!s->exporting)
+        dbus_session_set_audio_sinks(s->session,
+                (const gchar *const *)s->audiosink_paths->pdata);
+}
 
-    dbus_session_set_audio_sinks(s->session, paths);
-    g_free(paths);
+/* The latest state of a sink, applied to its skeleton when throttled changes
+ * are flushed. */
+typedef struct {
+    DBusServer *s;
+    DBusAudioSink *das;
+    gchar *name;
+    gboolean mute;
+    gdouble volume;
+} AudioSinkUpdate;
+
+static AudioSinkUpdate *
+get_update(DBusAudioSink *das)
+{
+    return dbus_server_get_throttle(das)->user_data;
 }
 
 static gboolean
@@ -83,7 +88,7 @@ on_handle_inc_volume(DBusAudioSink *das, GDBusMethodInvocation *i,
         return FALSE;
 
     guint32 id = dbus_audio_sink_get_id(das);
-    gdouble vol = dbus_audio_sink_get_volume(das);
+    gdouble vol = get_update(das)->volume;
     vol = MIN(MAX(vol + v, 0.0), 1.0);
 
     if (!audiosink_set_volume(id, vol, s->wp_conn)) {
@@ -127,7 +132,7 @@ on_handle_toggle_mute(DBusAudioSink *das, GDBusMethodInvocation *i,
         return FALSE;
 
     guint32 id = dbus_audio_sink_get_id(das);
-    gboolean mute = !dbus_audio_sink_get_mute(das);
+    gboolean mute = !get_update(das)->mute;
 
     if (!audiosink_set_mute(id, mute, s->wp_conn)) {
         g_dbus_method_invocation_return_dbus_error(i,
@@ -164,23 +169,52 @@ update_audiosink(DBusAudioSink *das, struct AudioSink *as)
     }
 }
 
+static void
+set_update(AudioSinkUpdate *u, struct AudioSink *as)
+{
+    if (as->name && g_strcmp0(u->name, as->name) != 0) {
+        g_free(u->name);
+        u->name = g_strdup(as->name);
+    }
+    u->mute = as->mute;
+    u->volume = as->volume;
+}
+
+static void
+flush_audiosink(gpointer user_data)
+{
+    AudioSinkUpdate *u = (AudioSinkUpdate *)user_data;
+    struct AudioSink as = {
+        .id = dbus_audio_sink_get_id(u->das),
+        .name = u->name,
+        .mute = u->mute,
+        .volume = u->volume,
+    };
+
+    update_audiosink(u->das, &as);
+
+    const gchar *path = g_dbus_interface_skeleton_get_object_path(
+            G_DBUS_INTERFACE_SKELETON(u->das));
+    if (path)
+        dbus_server_push_event(u->s, "AudioSink",
+                g_variant_new("(odb)", path, as.volume, as.mute));
+}
+
+static void
+free_update(AudioSinkUpdate *u)
+{
+    g_free(u->name);
+    g_free(u);
+}
+
 gboolean
 dbus_server_export_audiosink(DBusServer *s, DBusAudioSink *das)
 {
     guint32 id = dbus_audio_sink_get_id(das);
     gchar *path = g_strdup_printf("%s/%d", DBUS_AUDIOSINK_PATH, id);
 
-    GError *err = NULL;
-    g_dbus_interface_skeleton_export(G_DBUS_INTERFACE_SKELETON(das), s->conn,
-            path, &err);
-
-    if (err) {
-        g_error("Failed to export DBus AudioSink interface: %s", err->message);
-        g_error_free(err);
-        g_free(path);
-        return FALSE;
-    }
-
+    dbus_server_export_object(s, das, path);
+    dbus_server_add_path(s->audiosink_paths, path);
     set_audio_sinks_property(s);
 
     dbus_session_emit_add_audio_sink(s->session, path);
@@ -195,7 +229,9 @@ dbus_server_unexport_audiosink(DBusServer *s, DBusAudioSink *das)
     GDBusInterfaceSkeleton *skel = G_DBUS_INTERFACE_SKELETON(das);
     gchar *path = g_strdup(g_dbus_interface_skeleton_get_object_path(skel));
 
-    g_dbus_interface_skeleton_unexport(skel);
+    dbus_server_unexport_object(s, das);
+    dbus_server_invalidate_state(s);
+    dbus_server_remove_path(s->audiosink_paths, path);
     set_audio_sinks_property(s);
 
     dbus_session_emit_remove_audio_sink(s->session, path);
@@ -218,6 +254,14 @@ dbus_server_add_audiosink(DBusServer *s, struct AudioSink *as)
     g_signal_connect(das, "handle-toggle-mute",
             G_CALLBACK(on_handle_toggle_mute), s);
 
+    AudioSinkUpdate *u = g_malloc0(sizeof(AudioSinkUpdate));
+    u->s = s;
+    u->das = das;
+    set_update(u, as);
+    dbus_server_throttle_object(s, das, flush_audiosink, u,
+            (GDestroyNotify)free_update);
+
+    dbus_server_watch_state(s, das);
     update_audiosink(das, as);
 
     if (s->name_acquired)
@@ -242,8 +286,11 @@ dbus_server_update_audiosink(DBusServer *s, struct AudioSink *as)
 {
     DBusAudioSink *das = g_hash_table_lookup(s->audiosinks, INT_PTR(as->id));
 
-    if (das)
-        update_audiosink(das, as);
+    if (!das)
+        return;
+
+    set_update(get_update(das), as);
+    throttle_queue(dbus_server_get_throttle(das));
 }
 
 void
@@ -0,0 +1,213 @@
+/*
+sessiond - standalone X session manager
+Copyright (C) 2019-2020 James Reed
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#define G_LOG_DOMAIN "sessiond"
+
+#include "dbus-backlight-group.h"
+#include "dbus-server.h"
+#include "dbus-gen.h"
+#include "backlight.h"
+#include "config.h"
+
+#include <glib-2.0/glib.h>
+
+struct GroupCall {
+    DBusBacklightGroup *dbg;
+    GDBusMethodInvocation *invocation;
+    const gchar *method;
+};
+
+static void
+set_backlight_groups_property(DBusServer *s)
+{
+    if (!s->exporting)
+        dbus_session_set_backlight_groups(s->session,
+                (const gchar *const *)s->backlight_group_paths->pdata);
+}
+
+static void
+on_group_done(gboolean success, gpointer user_data)
+{
+    struct GroupCall *call = user_data;
+
+    if (!success) {
+        gchar *name = g_strconcat(DBUS_BACKLIGHT_GROUP_ERROR ".",
+                call->method, NULL);
+        g_dbus_method_invocation_return_dbus_error(call->invocation, name,
+                "Failed to set brightness of all group members");
+        g_free(name);
+    } else {
+        g_dbus_method_invocation_return_value(call->invocation, NULL);
+    }
+
+    g_object_unref(call->dbg);
+    g_free(call);
+}
+
+static gboolean
+set_group_brightness(DBusBacklightGroup *dbg, GDBusMethodInvocation *i,
+        const gchar *method, gint64 v, gboolean inc, DBusServer *s)
+{
+    if (!s->bl_devices || !s->bl_group_confs)
+        return FALSE;
+
+    const gchar *name = dbus_backlight_group_get_name(dbg);
+    struct BacklightGroupConf *g = g_hash_table_lookup(s->bl_group_confs,
+            name);
+    if (!g)
+        return FALSE;
+
+    GArray *writes = g_array_new(FALSE, FALSE, sizeof(struct BacklightWrite));
+
+    for (guint n = 0; n < g->members->len; n++) {
+        struct BacklightGroupMember *m = &g_array_index(g->members,
+                struct BacklightGroupMember, n);
+        struct Backlight *bl = g_hash_table_lookup(s->bl_devices, m->path);
+
+        if (!bl || (inc && (!backlight_resolve(bl) || bl->brightness == -1)))
+            continue;
+
+        gdouble d = v * m->scale;
+        d += d < 0 ? -0.5 : 0.5;
+        if (inc)
+            d += bl->brightness;
+
+        struct BacklightWrite w = {bl, (guint32)MAX(d, 0)};
+        g_array_append_val(writes, w);
+    }
+
+    if (!writes->len) {
+        gchar *err = g_strconcat(DBUS_BACKLIGHT_GROUP_ERROR ".", method, NULL);
+        g_dbus_method_invocation_return_dbus_error(i, err,
+                "No group members are present");
+        g_free(err);
+        g_array_unref(writes);
+        return TRUE;
+    }
+
+    struct GroupCall *call = g_malloc(sizeof(struct GroupCall));
+    call->dbg = g_object_ref(dbg);
+    call->invocation = i;
+    call->method = method;
+
+    backlights_set_brightness_async(writes, s->ctx, on_group_done, call);
+    g_array_unref(writes);
+
+    return TRUE;
+}
+
+static gboolean
+on_handle_set_brightness(DBusBacklightGroup *dbg, GDBusMethodInvocation *i,
+        guint32 v, gpointer user_data)
+{
+    return set_group_brightness(dbg, i, "SetBrightness", v, FALSE,
+            (DBusServer *)user_data);
+}
+
+static gboolean
+on_handle_inc_brightness(DBusBacklightGroup *dbg, GDBusMethodInvocation *i,
+        gint v, gpointer user_data)
+{
+    return set_group_brightness(dbg, i, "IncBrightness", v, TRUE,
+            (DBusServer *)user_data);
+}
+
+static DBusBacklightGroup *
+new_backlight_group(DBusServer *s, struct BacklightGroupConf *g)
+{
+    DBusBacklightGroup *dbg = dbus_backlight_group_skeleton_new();
+    const gchar **members = g_malloc0_n(g->members->len + 1, sizeof(gchar *));
+
+    for (guint i = 0; i < g->members->len; i++)
+        members[i] = g_array_index(g->members, struct BacklightGroupMember,
+                i).path;
+
+    dbus_backlight_group_set_name(dbg, g->name);
+    dbus_backlight_group_set_members(dbg, members);
+    g_free(members);
+
+    g_signal_connect(dbg, "handle-set-brightness",
+            G_CALLBACK(on_handle_set_brightness), s);
+    g_signal_connect(dbg, "handle-inc-brightness",
+            G_CALLBACK(on_handle_inc_brightness), s);
+
+    return dbg;
+}
+
+gboolean
+dbus_server_export_backlight_group(DBusServer *s, DBusBacklightGroup *dbg)
+{
+    gchar *path = g_strdup_printf("%s/%s", DBUS_BACKLIGHT_GROUP_PATH,
+            dbus_backlight_group_get_name(dbg));
+
+    dbus_server_export_object(s, dbg, path);
+    dbus_server_add_path(s->backlight_group_paths, path);
+    g_free(path);
+
+    set_backlight_groups_property(s);
+
+    return TRUE;
+}
+
+void
+dbus_server_unexport_backlight_group(DBusServer *s, DBusBacklightGroup *dbg)
+{
+    GDBusInterfaceSkeleton *skel = G_DBUS_INTERFACE_SKELETON(dbg);
+    gchar *path = g_strdup(g_dbus_interface_skeleton_get_object_path(skel));
+
+    dbus_server_unexport_object(s, dbg);
+    if (path)
+        dbus_server_remove_path(s->backlight_group_paths, path);
+    set_backlight_groups_property(s);
+    g_free(path);
+}
+
+/* Replace exported groups with those in groups, which must outlive them. */
+void
+dbus_server_set_backlight_groups(DBusServer *s, GHashTable *groups)
+{
+    GHashTableIter iter;
+    gpointer val;
+    gboolean exporting = s->exporting;
+
+    /* The BacklightGroups property is set once for the whole table. */
+    s->exporting = TRUE;
+
+    g_hash_table_iter_init(&iter, s->backlight_groups);
+    while (g_hash_table_iter_next(&iter, NULL, &val)) {
+        dbus_server_unexport_object(s, val);
+        g_hash_table_iter_remove(&iter);
+    }
+
+    s->bl_group_confs = groups;
+
+    if (groups) {
+        g_hash_table_iter_init(&iter, groups);
+        while (g_hash_table_iter_next(&iter, NULL, &val)) {
+            struct BacklightGroupConf *g = val;
+            DBusBacklightGroup *dbg = new_backlight_group(s, g);
+
+            g_hash_table_insert(s->backlight_groups, g_strdup(g->name), dbg);
+
+            if (s->name_acquired)
+                dbus_server_export_backlight_group(s, dbg);
+        }
+    }
+
+    s->exporting = exporting;
+    set_backlight_groups_property(s);
+}
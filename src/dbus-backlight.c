@@ -27,20 +27,9 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 static void
 set_backlights_property(DBusServer *s)
 {
-    GList *dbls = g_hash_table_get_values(s->backlights);
-    const gchar **paths = g_malloc0_n(g_list_length(dbls) + 1, sizeof(gchar *));
-
-    guint n = 0;
-    for (GList *i = dbls; i; i = i->next, n++) {
-        DBusBacklight *dbl = i->data;
-        const gchar *path = g_dbus_interface_skeleton_get_object_path(
-                G_DBUS_INTERFACE_SKELETON(dbl));
-        if (path)
-            paths[n] = path;
-    }
-
-    dbus_session_set_backlights(s->session, paths);
-    g_free(paths);
+    if (!s->exporting)
+        dbus_session_set_backlights(s->session,
+                (const gchar *const *)s->backlight_paths->pdata);
 }
 
 static gboolean
@@ -86,6 +75,7 @@ on_handle_inc_brightness(DBusBacklight *dbl, GDBusMethodInvocation *i,
     if (!bl)
         return FALSE;
 
+    backlight_resolve(bl);
     guint b = MAX(bl->brightness + v, 0);
     if (!backlight_set_brightness(bl, b, s->ctx)) {
         g_dbus_method_invocation_return_dbus_error(i,
@@ -98,6 +88,77 @@ on_handle_inc_brightness(DBusBacklight *dbl, GDBusMethodInvocation *i,
     return TRUE;
 }
 
+static struct Backlight *
+get_backlight(DBusServer *s, DBusBacklight *dbl)
+{
+    if (!s->bl_devices)
+        return NULL;
+
+    const gchar *sys_path = dbus_backlight_get_sys_path(dbl);
+    if (!sys_path)
+        return NULL;
+
+    return g_hash_table_lookup(s->bl_devices, sys_path);
+}
+
+static gboolean
+on_handle_set_brightness_percent(DBusBacklight *dbl, GDBusMethodInvocation *i,
+        gdouble p, gpointer user_data)
+{
+    DBusServer *s = (DBusServer *)user_data;
+    struct Backlight *bl = get_backlight(s, dbl);
+
+    if (!bl)
+        return FALSE;
+
+    gint32 v = backlight_percent_to_brightness(bl, p);
+    if (v == -1 || !backlight_set_brightness(bl, v, s->ctx)) {
+        g_dbus_method_invocation_return_dbus_error(i,
+                DBUS_BACKLIGHT_ERROR ".SetBrightnessPercent",
+                "Failed to set brightness");
+        return TRUE;
+    }
+
+    dbus_backlight_complete_set_brightness_percent(dbl, i);
+    return TRUE;
+}
+
+static gboolean
+on_handle_inc_brightness_percent(DBusBacklight *dbl, GDBusMethodInvocation *i,
+        gdouble v, gpointer user_data)
+{
+    DBusServer *s = (DBusServer *)user_data;
+    struct Backlight *bl = get_backlight(s, dbl);
+
+    if (!bl)
+        return FALSE;
+
+    gdouble p = backlight_brightness_to_percent(bl, bl->brightness);
+    gint32 b = -1;
+
+    if (p != -1) {
+        p = CLAMP(p + v, 0.0, 1.0);
+        b = backlight_percent_to_brightness(bl, p);
+        /* Always move by at least one raw step in the requested direction. */
+        if (b == bl->brightness) {
+            if (v > 0 && b < bl->max_brightness)
+                b++;
+            else if (v < 0 && b > 0)
+                b--;
+        }
+    }
+
+    if (b == -1 || !backlight_set_brightness(bl, b, s->ctx)) {
+        g_dbus_method_invocation_return_dbus_error(i,
+                DBUS_BACKLIGHT_ERROR ".IncBrightnessPercent",
+                "Failed to increment brightness");
+        return TRUE;
+    }
+
+    dbus_backlight_complete_inc_brightness_percent(dbl, i, p);
+    return TRUE;
+}
+
 static void
 update_backlight(DBusBacklight *dbl, struct Backlight *bl)
 {
@@ -121,6 +182,29 @@ update_backlight(DBusBacklight *dbl, struct Backlight *bl)
 #undef SET_INT
 }
 
+typedef struct {
+    DBusServer *s;
+    DBusBacklight *dbl;
+} BacklightUpdate;
+
+static void
+flush_backlight(gpointer user_data)
+{
+    BacklightUpdate *u = (BacklightUpdate *)user_data;
+    struct Backlight *bl = get_backlight(u->s, u->dbl);
+
+    if (!bl)
+        return;
+
+    update_backlight(u->dbl, bl);
+
+    const gchar *path = g_dbus_interface_skeleton_get_object_path(
+            G_DBUS_INTERFACE_SKELETON(u->dbl));
+    if (path)
+        dbus_server_push_event(u->s, "Backlight", g_variant_new("(ouu)",
+                    path, bl->brightness, bl->max_brightness));
+}
+
 gboolean
 dbus_server_export_backlight(DBusServer *s, DBusBacklight *dbl)
 {
@@ -132,17 +216,8 @@ dbus_server_export_backlight(DBusServer *s, DBusBacklight *dbl)
     if (norm)
         g_free(norm);
 
-    GError *err = NULL;
-    g_dbus_interface_skeleton_export(G_DBUS_INTERFACE_SKELETON(dbl), s->conn,
-            path, &err);
-
-    if (err) {
-        g_error("Failed to export DBus Backlight interface: %s", err->message);
-        g_error_free(err);
-        g_free(path);
-        return FALSE;
-    }
-
+    dbus_server_export_object(s, dbl, path);
+    dbus_server_add_path(s->backlight_paths, path);
     set_backlights_property(s);
 
     dbus_session_emit_add_backlight(s->session, path);
@@ -157,7 +232,9 @@ dbus_server_unexport_backlight(DBusServer *s, DBusBacklight *dbl)
     GDBusInterfaceSkeleton *skel = G_DBUS_INTERFACE_SKELETON(dbl);
     gchar *path = g_strdup(g_dbus_interface_skeleton_get_object_path(skel));
 
-    g_dbus_interface_skeleton_unexport(skel);
+    dbus_server_unexport_object(s, dbl);
+    dbus_server_invalidate_state(s);
+    dbus_server_remove_path(s->backlight_paths, path);
     set_backlights_property(s);
 
     dbus_session_emit_remove_backlight(s->session, path);
@@ -174,7 +251,17 @@ dbus_server_add_backlight(DBusServer *s, struct Backlight *bl)
             G_CALLBACK(on_handle_set_brightness), s);
     g_signal_connect(dbl, "handle-inc-brightness",
             G_CALLBACK(on_handle_inc_brightness), s);
+    g_signal_connect(dbl, "handle-set-brightness-percent",
+            G_CALLBACK(on_handle_set_brightness_percent), s);
+    g_signal_connect(dbl, "handle-inc-brightness-percent",
+            G_CALLBACK(on_handle_inc_brightness_percent), s);
+
+    BacklightUpdate *u = g_malloc(sizeof(BacklightUpdate));
+    u->s = s;
+    u->dbl = dbl;
+    dbus_server_throttle_object(s, dbl, flush_backlight, u, g_free);
 
+    dbus_server_watch_state(s, dbl);
     update_backlight(dbl, bl);
 
     if (s->name_acquired)
@@ -200,5 +287,5 @@ dbus_server_update_backlight(DBusServer *s, struct Backlight *bl)
     DBusBacklight *dbl = g_hash_table_lookup(s->backlights, bl->sys_path);
 
     if (dbl)
-        update_backlight(dbl, bl);
+        throttle_queue(dbus_server_get_throttle(dbl));
 }
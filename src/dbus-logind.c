@@ -31,6 +31,9 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 #define LOGIND_PATH "/org/freedesktop/login1"
 #define LOGIND_USER_PATH LOGIND_PATH "/user/self"
 
+/* Milliseconds to wait for logind to reply to a method call. */
+#define LOGIND_CALL_TIMEOUT 5000
+
 G_DEFINE_TYPE(LogindContext, logind_context, G_TYPE_OBJECT);
 
 enum {
@@ -39,6 +42,7 @@ enum {
     SHUTDOWN_SIGNAL,
     APPEAR_SIGNAL,
     VANISH_SIGNAL,
+    PROPERTIES_CHANGED_SIGNAL,
     LAST_SIGNAL,
 };
 
@@ -119,55 +123,90 @@ error:
     return path;
 }
 
-static void
-logind_get_property(LogindContext *c, const gchar *prop, const gchar *fmt,
-        gpointer out)
+/* Update the property mirror from a{sv}, returning the changed properties. */
+static guint
+logind_update_properties(LogindContext *c, GVariant *props)
 {
-    if (!c->logind_session) {
-        g_warning("Cannot get %s: %s does not exist", prop, LOGIND_NAME);
-        return;
+    guint changed = 0;
+    const gchar *prop;
+    GVariant *v;
+    GVariantIter iter;
+
+    g_variant_iter_init(&iter, props);
+
+    while (g_variant_iter_loop(&iter, "{&sv}", &prop, &v)) {
+#define X(p, name, fmt, type, field) \
+        if (g_strcmp0(prop, name) == 0) { \
+            if (!g_variant_is_of_type(v, G_VARIANT_TYPE(fmt))) { \
+                g_warning("Unexpected type of logind %s", name); \
+                continue; \
+            } \
+            type val; \
+            g_variant_get(v, fmt, &val); \
+            if (val != c->props.field) { \
+                c->props.field = val; \
+                changed |= LOGIND_PROPERTY_##p; \
+            } \
+            continue; \
+        }
+        LOGIND_PROPERTY_LIST
+#undef X
     }
 
-    GVariant *v = g_dbus_proxy_get_cached_property(c->logind_session,
-            prop);
-    if (v) {
-        g_variant_get(v, fmt, out);
-        g_variant_unref(v);
-    } else {
-        g_warning("Failed to get logind %s", prop);
+    return changed;
+}
+
+static void
+logind_load_properties(LogindContext *c)
+{
+#define X(p, name, fmt, type, field) \
+    { \
+        GVariant *v = g_dbus_proxy_get_cached_property(c->logind_session, \
+                name); \
+        if (v) { \
+            g_variant_get(v, fmt, &c->props.field); \
+            g_variant_unref(v); \
+        } else { \
+            g_warning("Failed to get logind %s", name); \
+        } \
     }
+    LOGIND_PROPERTY_LIST
+#undef X
+}
+
+static void
+logind_on_properties_changed(UNUSED GDBusProxy *proxy, GVariant *props,
+        UNUSED GStrv inv_props, gpointer user_data)
+{
+    LogindContext *c = (LogindContext *)user_data;
+    guint changed = logind_update_properties(c, props);
+
+    if (changed)
+        g_signal_emit(c, signals[PROPERTIES_CHANGED_SIGNAL], 0, changed);
 }
 
 gboolean
 logind_get_locked_hint(LogindContext *c)
 {
-    gboolean b = FALSE;
-    logind_get_property(c, "LockedHint", "b", &b);
-    return b;
+    return c->props.locked_hint;
 }
 
 gboolean
 logind_get_idle_hint(LogindContext *c)
 {
-    gboolean b = FALSE;
-    logind_get_property(c, "IdleHint", "b", &b);
-    return b;
+    return c->props.idle_hint;
 }
 
 guint64
 logind_get_idle_since_hint(LogindContext *c)
 {
-    guint64 i = 0;
-    logind_get_property(c, "IdleSinceHint", "t", &i);
-    return i;
+    return c->props.idle_since_hint;
 }
 
 guint64
 logind_get_idle_since_hint_monotonic(LogindContext *c)
 {
-    guint64 i = 0;
-    logind_get_property(c, "IdleSinceHintMonotonic", "t", &i);
-    return i;
+    return c->props.idle_since_hint_monotonic;
 }
 
 static void
@@ -192,6 +231,10 @@ logind_on_appear(GDBusConnection *conn, const gchar *name, const gchar *owner,
         } else {
             g_signal_connect(c->logind_session, "g-signal",
                              G_CALLBACK(logind_on_session_signal), user_data);
+            g_signal_connect(c->logind_session, "g-properties-changed",
+                             G_CALLBACK(logind_on_properties_changed),
+                             user_data);
+            logind_load_properties(c);
             g_debug("Using logind session %s: %s", c->session_id, path);
         }
         g_free(path);
@@ -241,35 +284,115 @@ logind_context_class_init(LogindContextClass *c)
             type, G_SIGNAL_RUN_LAST, 0, NULL, NULL, NULL, G_TYPE_NONE, 0);
     signals[VANISH_SIGNAL] = g_signal_new("vanish",
             type, G_SIGNAL_RUN_LAST, 0, NULL, NULL, NULL, G_TYPE_NONE, 0);
+    signals[PROPERTIES_CHANGED_SIGNAL] = g_signal_new("properties-changed",
+            type, G_SIGNAL_RUN_LAST, 0, NULL, NULL, NULL, G_TYPE_NONE, 1,
+            G_TYPE_UINT);
 }
 
 static void
 logind_context_init(LogindContext *self)
 {
+    self->requests = g_queue_new();
+    self->cancellable = g_cancellable_new();
     self->logind_watcher = g_bus_watch_name(
         G_BUS_TYPE_SYSTEM, LOGIND_NAME, G_BUS_NAME_WATCHER_FLAGS_NONE,
         logind_on_appear, logind_on_vanish, self, NULL);
 }
 
-void
-logind_set_idle_hint(LogindContext *c, gboolean state)
+static void
+free_request(LogindRequest *r)
 {
-    if (!c->logind_session) {
-        g_warning("Cannot set IdleHint: %s does not exist", LOGIND_NAME);
+    g_free(r->method);
+    g_variant_unref(r->params);
+    g_free(r);
+}
+
+static void
+logind_on_call_done(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    LogindRequest *r = (LogindRequest *)user_data;
+    GError *err = NULL;
+    GVariant *v = g_dbus_proxy_call_finish(G_DBUS_PROXY(source), res, &err);
+
+    if (v)
+        g_variant_unref(v);
+
+    /* The context is gone if its requests were cancelled. */
+    if (g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        g_error_free(err);
+        free_request(r);
         return;
     }
 
-    GError *err = NULL;
-    g_dbus_proxy_call_sync(c->logind_session, "SetIdleHint",
-                           g_variant_new("(b)", state), G_DBUS_CALL_FLAGS_NONE,
-                           -1, NULL, &err);
+    g_queue_remove(r->ctx->requests, r);
+
+    gint64 ms = (g_get_monotonic_time() - r->start) / 1000;
 
     if (err) {
-        g_warning("%s", err->message);
+        g_warning("%s failed after %" G_GINT64_FORMAT "ms: %s", r->method, ms,
+                  err->message);
         g_error_free(err);
     } else {
-        g_debug("IdleHint set to %s", BOOLSTR(state));
+        gchar *params = g_variant_print(r->params, FALSE);
+        g_debug("%s%s completed in %" G_GINT64_FORMAT "ms", r->method, params,
+                ms);
+        g_free(params);
+    }
+
+    free_request(r);
+}
+
+/* Returns TRUE if the call is identical to the last queued request. Only the
+ * tail is compared: an earlier identical call may have been superseded by
+ * another in between, such as Unlock between two Locks. */
+gboolean
+logind_request_pending(GQueue *requests, const gchar *method,
+        GVariant *params)
+{
+    LogindRequest *r = g_queue_peek_tail(requests);
+
+    return r && g_strcmp0(r->method, method) == 0
+        && g_variant_equal(r->params, params);
+}
+
+/* Queue a session method call. Calls are sent immediately and in order, so
+ * several may be in flight at once; a call identical to the last queued call
+ * is dropped. */
+static void
+logind_call(LogindContext *c, const gchar *method, GVariant *params)
+{
+    if (!params)
+        params = g_variant_new("()");
+    g_variant_ref_sink(params);
+
+    if (logind_request_pending(c->requests, method, params)) {
+        g_debug("%s already pending", method);
+        g_variant_unref(params);
+        return;
+    }
+
+    LogindRequest *r = g_malloc(sizeof(LogindRequest));
+    r->ctx = c;
+    r->method = g_strdup(method);
+    r->params = params;
+    r->start = g_get_monotonic_time();
+
+    g_queue_push_tail(c->requests, r);
+
+    g_dbus_proxy_call(c->logind_session, method, params,
+                      G_DBUS_CALL_FLAGS_NONE, LOGIND_CALL_TIMEOUT,
+                      c->cancellable, logind_on_call_done, r);
+}
+
+void
+logind_set_idle_hint(LogindContext *c, gboolean state)
+{
+    if (!c->logind_session) {
+        g_warning("Cannot set IdleHint: %s does not exist", LOGIND_NAME);
+        return;
     }
+
+    logind_call(c, "SetIdleHint", g_variant_new("(b)", state));
 }
 
 /* Locking session automatically updates logind LockedHint. */
@@ -284,16 +407,7 @@ logind_lock_session(LogindContext *c, gboolean state)
         return;
     }
 
-    GError *err = NULL;
-    g_dbus_proxy_call_sync(c->logind_session, STR(state), NULL,
-                           G_DBUS_CALL_FLAGS_NONE, -1, NULL, &err);
-
-    if (err) {
-        g_warning("%s", err->message);
-        g_error_free(err);
-    } else {
-        g_debug("%sed session", STR(state));
-    }
+    logind_call(c, STR(state), NULL);
 
 #undef STR
 }
@@ -307,17 +421,7 @@ logind_set_locked_hint(LogindContext *c, gboolean state)
         return;
     }
 
-    GError *err = NULL;
-    g_dbus_proxy_call_sync(c->logind_session, "SetLockedHint",
-                           g_variant_new("(b)", state), G_DBUS_CALL_FLAGS_NONE,
-                           -1, NULL, &err);
-
-    if (err) {
-        g_warning("%s", err->message);
-        g_error_free(err);
-    } else {
-        g_debug("LockedHint set to %s", BOOLSTR(state));
-    }
+    logind_call(c, "SetLockedHint", g_variant_new("(b)", state));
 }
 
 gboolean
@@ -332,7 +436,8 @@ logind_set_brightness(LogindContext *c, const char *sys, const char *name,
     GError *err = NULL;
     g_dbus_proxy_call_sync(c->logind_session, "SetBrightness",
                            g_variant_new("(ssu)", sys, name, v),
-                           G_DBUS_CALL_FLAGS_NONE, -1, NULL, &err);
+                           G_DBUS_CALL_FLAGS_NONE, LOGIND_CALL_TIMEOUT, NULL,
+                           &err);
     if (err) {
         g_error_free(err);
         return FALSE;
@@ -341,6 +446,45 @@ logind_set_brightness(LogindContext *c, const char *sys, const char *name,
     return TRUE;
 }
 
+/* Returns FALSE without invoking callback if logind is unavailable. */
+gboolean
+logind_set_brightness_async(LogindContext *c, const char *sys,
+        const char *name, guint32 v, GAsyncReadyCallback callback,
+        gpointer user_data)
+{
+    if (!c->logind_session) {
+        g_warning("Cannot set brightness: %s does not exist", LOGIND_NAME);
+        return FALSE;
+    }
+
+    g_dbus_proxy_call(c->logind_session, "SetBrightness",
+                      g_variant_new("(ssu)", sys, name, v),
+                      G_DBUS_CALL_FLAGS_NONE, LOGIND_CALL_TIMEOUT, NULL,
+                      callback, user_data);
+
+    return TRUE;
+}
+
+gboolean
+logind_set_brightness_finish(GAsyncResult *res)
+{
+    GObject *proxy = g_async_result_get_source_object(res);
+    GError *err = NULL;
+    GVariant *v = g_dbus_proxy_call_finish(G_DBUS_PROXY(proxy), res, &err);
+
+    g_object_unref(proxy);
+
+    if (err) {
+        g_debug("Failed to set brightness via %s: %s", LOGIND_NAME,
+                err->message);
+        g_error_free(err);
+        return FALSE;
+    }
+
+    g_variant_unref(v);
+    return TRUE;
+}
+
 LogindContext *
 logind_context_new(void)
 {
@@ -366,5 +510,14 @@ logind_context_free(LogindContext *c)
         g_object_unref(c->logind_manager);
         c->logind_manager = NULL;
     }
+    if (c->cancellable) {
+        g_cancellable_cancel(c->cancellable);
+        g_clear_object(&c->cancellable);
+    }
+    /* Cancelled requests free themselves. */
+    if (c->requests) {
+        g_queue_free(c->requests);
+        c->requests = NULL;
+    }
     g_object_unref(c);
 }
@@ -20,6 +20,32 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 #include <glib-2.0/glib.h>
 #include <glib-2.0/gio/gio.h>
 
+#define LOGIND_PROPERTY_LIST \
+    X(LOCKED_HINT, "LockedHint", "b", gboolean, locked_hint) \
+    X(IDLE_HINT, "IdleHint", "b", gboolean, idle_hint) \
+    X(IDLE_SINCE_HINT, "IdleSinceHint", "t", guint64, idle_since_hint) \
+    X(IDLE_SINCE_HINT_MONOTONIC, "IdleSinceHintMonotonic", "t", guint64, \
+            idle_since_hint_monotonic)
+
+typedef enum {
+#define X(p, ...) LOGIND_PROPERTY_BIT_##p,
+    LOGIND_PROPERTY_LIST
+#undef X
+} LogindPropertyBit;
+
+typedef enum {
+#define X(p, ...) LOGIND_PROPERTY_##p = 1 << LOGIND_PROPERTY_BIT_##p,
+    LOGIND_PROPERTY_LIST
+#undef X
+} LogindProperty;
+
+/* Mirror of the session's properties, updated on g-properties-changed. */
+typedef struct {
+#define X(p, name, fmt, type, field) type field;
+    LOGIND_PROPERTY_LIST
+#undef X
+} LogindProperties;
+
 #define LOGIND_TYPE_CONTEXT logind_context_get_type()
 G_DECLARE_FINAL_TYPE(LogindContext, logind_context, LOGIND, CONTEXT, GObject);
 
@@ -29,8 +55,22 @@ struct _LogindContext {
     guint logind_watcher;
     GDBusProxy *logind_session;
     GDBusProxy *logind_manager;
+    LogindProperties props;
+    GQueue *requests;
+    GCancellable *cancellable;
 };
 
+/* A session method call in flight. */
+typedef struct {
+    LogindContext *ctx;
+    gchar *method;
+    GVariant *params;
+    gint64 start;
+} LogindRequest;
+
+extern gboolean
+logind_request_pending(GQueue *requests, const gchar *method,
+        GVariant *params);
 extern void
 logind_set_idle_hint(LogindContext *c, gboolean state);
 extern void
@@ -48,6 +88,12 @@ logind_get_idle_since_hint_monotonic(LogindContext *c);
 extern gboolean
 logind_set_brightness(LogindContext *c, const char *sys, const char *name,
         guint32 v);
+extern gboolean
+logind_set_brightness_async(LogindContext *c, const char *sys,
+        const char *name, guint32 v, GAsyncReadyCallback callback,
+        gpointer user_data);
+extern gboolean
+logind_set_brightness_finish(GAsyncResult *res);
 extern LogindContext *
 logind_context_new(void);
 extern void
@@ -21,6 +21,7 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 #include "dbus-logind.h"
 #include "dbus-gen.h"
 #include "dbus-backlight.h"
+#include "dbus-backlight-group.h"
 #include "common.h"
 #include "version.h"
 
@@ -28,18 +29,26 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 #include "dbus-audiosink.h"
 #endif /* WIREPLUMBER */
 
+#include <errno.h>
 #include <stdio.h>
+#include <unistd.h>
 #include <glib-2.0/glib.h>
+#include <glib-2.0/glib-unix.h>
+#include <glib-2.0/glib/gstdio.h>
 #include <glib-2.0/gio/gio.h>
+#include <gio/gunixfdlist.h>
 
-#define EXPORTED(i) (g_dbus_interface_skeleton_get_object_path(\
-            G_DBUS_INTERFACE_SKELETON(i)) != NULL)
+#define SKELETON_PATH(i) g_dbus_interface_skeleton_get_object_path(\
+            G_DBUS_INTERFACE_SKELETON(i))
+#define EXPORTED(i) (SKELETON_PATH(i) != NULL)
 
 G_DEFINE_TYPE(DBusServer, dbus_server, G_TYPE_OBJECT);
 
 enum {
     INHIBIT_SIGNAL,
     UNINHIBIT_SIGNAL,
+    ADD_TIMEOUT_SIGNAL,
+    REMOVE_TIMEOUT_SIGNAL,
     LAST_SIGNAL,
 };
 
@@ -92,16 +101,185 @@ on_handle_inhibit(DBusSession *session, GDBusMethodInvocation *i,
         const gchar *who, const gchar *why, gpointer user_data)
 {
     DBusServer *s = (DBusServer *)user_data;
-    gchar *id = g_uuid_string_random();
+    struct Inhibitor *inh = inhibitors_add(s->inhibitors, who, why);
 
-    GVariant *inhibit = g_variant_new("(tss)", g_get_real_time(), who, why);
-    g_variant_ref_sink(inhibit);
-    g_hash_table_insert(s->inhibitors, id, inhibit);
+    g_signal_emit(s, signals[INHIBIT_SIGNAL], 0, who, why,
+            inhibitors_size(s->inhibitors));
+
+    dbus_session_complete_inhibit(session, i, inh->id);
+
+    return TRUE;
+}
+
+static void
+schedule_expiry(DBusServer *s);
+
+static void
+release_inhibitor(DBusServer *s, struct Inhibitor *inh)
+{
+    g_signal_emit(s, signals[UNINHIBIT_SIGNAL], 0, inh->who, inh->why,
+            inhibitors_size(s->inhibitors));
+    inhibitor_free(inh);
+    schedule_expiry(s);
+}
+
+static gboolean
+on_expiry(gpointer user_data)
+{
+    DBusServer *s = (DBusServer *)user_data;
+    struct Inhibitor *inh;
+
+    g_source_unref(s->expiry_source);
+    s->expiry_source = NULL;
+    s->expiry_time = -1;
+
+    while ((inh = inhibitors_pop_expired(s->inhibitors,
+                    g_get_monotonic_time()))) {
+        g_debug("Inhibitor expired: id='%s'", inh->id);
+        release_inhibitor(s, inh);
+    }
+
+    schedule_expiry(s);
+
+    return G_SOURCE_REMOVE;
+}
+
+/* A single timeout source fires at the earliest inhibitor expiry. */
+static void
+schedule_expiry(DBusServer *s)
+{
+    gint64 next = inhibitors_next_expiry(s->inhibitors);
+
+    if (next == s->expiry_time)
+        return;
+
+    if (s->expiry_source) {
+        g_source_destroy(s->expiry_source);
+        g_source_unref(s->expiry_source);
+        s->expiry_source = NULL;
+    }
+
+    s->expiry_time = next;
+
+    if (next == -1)
+        return;
+
+    gint64 delay = MAX(next - g_get_monotonic_time(), 0);
+
+    s->expiry_source = g_timeout_source_new((delay + 999) / 1000);
+    g_source_set_callback(s->expiry_source, on_expiry, s, NULL);
+    g_source_attach(s->expiry_source, NULL);
+}
+
+static gboolean
+on_handle_inhibit_for(DBusSession *session, GDBusMethodInvocation *i,
+        const gchar *who, const gchar *why, guint sec, gpointer user_data)
+{
+    if (sec > INHIBITOR_MAX_SEC) {
+        g_dbus_method_invocation_return_dbus_error(i,
+                DBUS_SESSION_ERROR ".InhibitFor", "Duration is too long");
+        return TRUE;
+    }
+
+    DBusServer *s = (DBusServer *)user_data;
+    struct Inhibitor *inh = inhibitors_add(s->inhibitors, who, why);
+
+    if (sec) {
+        inhibitors_set_timeout(s->inhibitors, inh, g_get_monotonic_time(),
+                sec);
+        schedule_expiry(s);
+    }
+
+    g_signal_emit(s, signals[INHIBIT_SIGNAL], 0, who, why,
+            inhibitors_size(s->inhibitors));
+
+    dbus_session_complete_inhibit_for(session, i, inh->id);
+
+    return TRUE;
+}
+
+typedef struct {
+    DBusServer *s;
+    gchar *id;
+} InhibitorWatch;
+
+static void
+free_inhibitor_watch(InhibitorWatch *w)
+{
+    g_free(w->id);
+    g_free(w);
+}
+
+/* The inhibitor is held until the client closes its end of the pipe. Anything
+ * written to the pipe is drained and ignored. */
+static gboolean
+on_inhibitor_fd(gint fd, GIOCondition cond, gpointer user_data)
+{
+    InhibitorWatch *w = (InhibitorWatch *)user_data;
+
+    if (!(cond & (G_IO_HUP | G_IO_ERR))) {
+        gchar buf[256];
+        gssize n = read(fd, buf, sizeof(buf));
+        if (n > 0 || (n == -1 && (errno == EINTR || errno == EAGAIN)))
+            return G_SOURCE_CONTINUE;
+    }
+
+    struct Inhibitor *inh = inhibitors_steal(w->s->inhibitors, w->id);
+
+    if (inh) {
+        g_debug("Inhibitor fd closed: id='%s'", inh->id);
+        inh->fd_watch = 0;
+        release_inhibitor(w->s, inh);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+on_handle_inhibit_fd(DBusSession *session, GDBusMethodInvocation *i,
+        UNUSED GUnixFDList *in_fds, const gchar *who, const gchar *why,
+        gpointer user_data)
+{
+    DBusServer *s = (DBusServer *)user_data;
+    GError *err = NULL;
+    gint fds[2];
+
+    if (!g_unix_open_pipe(fds, FD_CLOEXEC, &err)) {
+        g_dbus_method_invocation_return_dbus_error(i,
+                DBUS_SESSION_ERROR ".InhibitFd", err->message);
+        g_error_free(err);
+        return TRUE;
+    }
+
+    GUnixFDList *out_fds = g_unix_fd_list_new();
+    gint index = g_unix_fd_list_append(out_fds, fds[1], &err);
+    close(fds[1]);
+
+    if (index == -1) {
+        g_dbus_method_invocation_return_dbus_error(i,
+                DBUS_SESSION_ERROR ".InhibitFd", err->message);
+        g_error_free(err);
+        g_object_unref(out_fds);
+        close(fds[0]);
+        return TRUE;
+    }
+
+    struct Inhibitor *inh = inhibitors_add(s->inhibitors, who, why);
+
+    InhibitorWatch *w = g_malloc(sizeof(InhibitorWatch));
+    w->s = s;
+    w->id = g_strdup(inh->id);
+
+    inh->fd = fds[0];
+    inh->fd_watch = g_unix_fd_add_full(G_PRIORITY_DEFAULT, fds[0],
+            G_IO_IN | G_IO_HUP | G_IO_ERR, on_inhibitor_fd, w,
+            (GDestroyNotify)free_inhibitor_watch);
 
     g_signal_emit(s, signals[INHIBIT_SIGNAL], 0, who, why,
-            g_hash_table_size(s->inhibitors));
+            inhibitors_size(s->inhibitors));
 
-    dbus_session_complete_inhibit(session, i, id);
+    dbus_session_complete_inhibit_fd(session, i, out_fds, index, inh->id);
+    g_object_unref(out_fds);
 
     return TRUE;
 }
@@ -117,25 +295,15 @@ on_handle_uninhibit(DBusSession *session, GDBusMethodInvocation *i,
     }
 
     DBusServer *s = (DBusServer *)user_data;
+    struct Inhibitor *inh = inhibitors_steal(s->inhibitors, id);
 
-    gint64 timestamp;
-    gchar *who;
-    gchar *why;
-    GVariant *v = g_hash_table_lookup(s->inhibitors, id);
-    if (!v) {
+    if (!inh) {
         g_dbus_method_invocation_return_dbus_error(i,
                 DBUS_SESSION_ERROR ".Uninhibit", "Inhibitor ID does not exist");
         return TRUE;
     }
-    g_variant_get(v, "(tss)", &timestamp, &who, &why);
-
-    g_hash_table_remove(s->inhibitors, id);
-    guint n = g_hash_table_size(s->inhibitors);
-
-    g_signal_emit(s, signals[UNINHIBIT_SIGNAL], 0, who, why, n);
 
-    g_free(who);
-    g_free(why);
+    release_inhibitor(s, inh);
 
     dbus_session_complete_uninhibit(session, i);
 
@@ -147,61 +315,674 @@ on_handle_stop_inhibitors(DBusSession *session, GDBusMethodInvocation *i,
         gpointer user_data)
 {
     DBusServer *s = (DBusServer *)user_data;
-    guint count = g_hash_table_size(s->inhibitors);
-    guint n = count;
+    guint count = inhibitors_size(s->inhibitors);
+    struct Inhibitor *inh;
+
+    while ((inh = inhibitors_pop(s->inhibitors)))
+        release_inhibitor(s, inh);
+
+    dbus_session_complete_stop_inhibitors(session, i, count);
+
+    return TRUE;
+}
+
+static gboolean
+on_handle_list_inhibitors(DBusSession *session, GDBusMethodInvocation *i,
+        gpointer user_data)
+{
+    DBusServer *s = (DBusServer *)user_data;
+
+    dbus_session_complete_list_inhibitors(session, i,
+            inhibitors_list(s->inhibitors));
+
+    return TRUE;
+}
+
+static gboolean
+on_handle_get_inhibitor_expiries(DBusSession *session,
+        GDBusMethodInvocation *i, gpointer user_data)
+{
+    DBusServer *s = (DBusServer *)user_data;
+
+    dbus_session_complete_get_inhibitor_expiries(session, i,
+            inhibitors_list_expiries(s->inhibitors));
+
+    return TRUE;
+}
+
+/* Add an inhibitor held by sessiond itself. Returns its ID, to be freed by the
+ * caller. */
+gchar *
+dbus_server_inhibit(DBusServer *s, const gchar *who, const gchar *why)
+{
+    struct Inhibitor *inh = inhibitors_add(s->inhibitors, who, why);
+
+    g_signal_emit(s, signals[INHIBIT_SIGNAL], 0, who, why,
+            inhibitors_size(s->inhibitors));
+
+    return g_strdup(inh->id);
+}
+
+/* Remove an inhibitor added by dbus_server_inhibit, unless it was already
+ * removed with StopInhibitors or Uninhibit. */
+void
+dbus_server_uninhibit(DBusServer *s, const gchar *id)
+{
+    struct Inhibitor *inh = inhibitors_steal(s->inhibitors, id);
+
+    if (inh)
+        release_inhibitor(s, inh);
+}
+
+/* A client with inactive timeouts, an inactive progress interval or an event
+ * subscription, dropped when its bus name vanishes or its peer connection
+ * closes. Timeouts are counted per timeout. Peers have no unique name and
+ * are keyed by their connection. */
+typedef struct {
+    DBusServer *s;
+    gchar *name;
+    const gchar *sender;
+    GDBusConnection *conn;
+    guint watch;
+    gulong closed_id;
+    GHashTable *timeouts;
+    guint progress;
+    gboolean subscribed;
+} Client;
+
+static void
+update_progress(DBusServer *s);
+
+static gchar *
+client_key(GDBusMethodInvocation *i)
+{
+    const gchar *sender = g_dbus_method_invocation_get_sender(i);
+
+    if (sender)
+        return g_strdup(sender);
 
+    return g_strdup_printf("peer:%p",
+            (gpointer)g_dbus_method_invocation_get_connection(i));
+}
+
+static void
+free_client(Client *c)
+{
     GHashTableIter iter;
-    gpointer k;
-    gpointer v;
-    gint64 timestamp;
-    gchar *who;
-    gchar *why;
+    gpointer key, val;
+
+    g_hash_table_iter_init(&iter, c->timeouts);
+    while (g_hash_table_iter_next(&iter, &key, &val))
+        for (guint n = GPOINTER_TO_UINT(val); n > 0; n--)
+            g_signal_emit(c->s, signals[REMOVE_TIMEOUT_SIGNAL], 0,
+                    GPOINTER_TO_UINT(key));
+
+    if (c->progress)
+        progress_remove_interval(c->s->progress, c->progress);
+    if (c->watch)
+        g_bus_unwatch_name(c->watch);
+    if (c->closed_id)
+        g_signal_handler_disconnect(c->conn, c->closed_id);
+    g_object_unref(c->conn);
+    g_hash_table_destroy(c->timeouts);
+    g_free(c->name);
+    g_free(c);
+}
 
-    g_hash_table_iter_init(&iter, s->inhibitors);
+static void
+on_client_vanished(UNUSED GDBusConnection *conn, UNUSED const gchar *name,
+        gpointer user_data)
+{
+    Client *c = (Client *)user_data;
+    DBusServer *s = c->s;
 
-    while (g_hash_table_iter_next(&iter, &k, &v)) {
-        g_variant_get(v, "(tss)", &timestamp, &who, &why);
-        g_hash_table_iter_remove(&iter);
+    g_debug("Client vanished: %s", c->name);
+    g_hash_table_remove(s->clients, c->name);
+    update_progress(s);
+}
 
-        g_signal_emit(s, signals[UNINHIBIT_SIGNAL], 0, who, why, --n);
+static void
+on_client_closed(GDBusConnection *conn, UNUSED gboolean remote,
+        UNUSED GError *err, gpointer user_data)
+{
+    on_client_vanished(conn, NULL, user_data);
+}
+
+static Client *
+lookup_client(DBusServer *s, GDBusMethodInvocation *i)
+{
+    gchar *key = client_key(i);
+    Client *c = g_hash_table_lookup(s->clients, key);
+
+    g_free(key);
+
+    return c;
+}
 
-        g_free(who);
-        g_free(why);
+static Client *
+get_client(DBusServer *s, GDBusMethodInvocation *i)
+{
+    Client *c = lookup_client(s, i);
+
+    if (c)
+        return c;
+
+    const gchar *sender = g_dbus_method_invocation_get_sender(i);
+
+    c = g_malloc(sizeof(Client));
+    c->s = s;
+    c->name = client_key(i);
+    c->sender = sender ? c->name : NULL;
+    c->conn = g_object_ref(g_dbus_method_invocation_get_connection(i));
+    c->watch = 0;
+    c->closed_id = 0;
+    c->timeouts = g_hash_table_new(NULL, NULL);
+    c->progress = 0;
+    c->subscribed = FALSE;
+    g_hash_table_insert(s->clients, c->name, c);
+
+    if (sender)
+        c->watch = g_bus_watch_name_on_connection(c->conn, sender,
+                G_BUS_NAME_WATCHER_FLAGS_NONE, NULL, on_client_vanished, c,
+                NULL);
+    else
+        c->closed_id = g_signal_connect(c->conn, "closed",
+                G_CALLBACK(on_client_closed), c);
+
+    return c;
+}
+
+static void
+release_client(Client *c)
+{
+    if (!g_hash_table_size(c->timeouts) && !c->progress && !c->subscribed)
+        g_hash_table_remove(c->s->clients, c->name);
+}
+
+static void
+emit_to_client(Client *c, const gchar *signal, GVariant *params)
+{
+    GError *err = NULL;
+
+    g_dbus_connection_emit_signal(c->conn, c->sender, DBUS_PATH,
+            DBUS_NAME ".Session", signal, params, &err);
+    if (err) {
+        g_warning("Failed to emit %s to %s: %s", signal, c->name,
+                err->message);
+        g_error_free(err);
     }
+}
 
-    dbus_session_complete_stop_inhibitors(session, i, count);
+static gboolean
+on_handle_add_inactive_timeout(DBusSession *session, GDBusMethodInvocation *i,
+        guint sec, gpointer user_data)
+{
+    if (!sec) {
+        g_dbus_method_invocation_return_dbus_error(i,
+                DBUS_SESSION_ERROR ".AddInactiveTimeout",
+                "Timeout must be greater than zero");
+        return TRUE;
+    }
+
+    DBusServer *s = (DBusServer *)user_data;
+    Client *c = get_client(s, i);
+    gpointer t = GUINT_TO_POINTER(sec);
+    guint n = GPOINTER_TO_UINT(g_hash_table_lookup(c->timeouts, t));
+
+    g_hash_table_insert(c->timeouts, t, GUINT_TO_POINTER(n + 1));
+
+    g_signal_emit(s, signals[ADD_TIMEOUT_SIGNAL], 0, sec);
+
+    dbus_session_complete_add_inactive_timeout(session, i);
 
     return TRUE;
 }
 
 static gboolean
-on_handle_list_inhibitors(DBusSession *session, GDBusMethodInvocation *i,
-        gpointer user_data)
+on_handle_remove_inactive_timeout(DBusSession *session,
+        GDBusMethodInvocation *i, guint sec, gpointer user_data)
 {
     DBusServer *s = (DBusServer *)user_data;
-    GVariantBuilder b;
-    GVariant *dict;
+    Client *c = lookup_client(s, i);
+    gpointer key = GUINT_TO_POINTER(sec);
+    guint n = c ? GPOINTER_TO_UINT(g_hash_table_lookup(c->timeouts, key)) : 0;
+
+    if (!n) {
+        g_dbus_method_invocation_return_dbus_error(i,
+                DBUS_SESSION_ERROR ".RemoveInactiveTimeout",
+                "Timeout is not registered");
+        return TRUE;
+    }
+
+    if (n > 1)
+        g_hash_table_insert(c->timeouts, key, GUINT_TO_POINTER(n - 1));
+    else
+        g_hash_table_remove(c->timeouts, key);
+
+    g_signal_emit(s, signals[REMOVE_TIMEOUT_SIGNAL], 0, sec);
+    release_client(c);
 
-    g_variant_builder_init(&b, G_VARIANT_TYPE("a{s(tss)}"));
+    dbus_session_complete_remove_inactive_timeout(session, i);
 
+    return TRUE;
+}
+
+static void
+on_progress(guint elapsed, gpointer user_data)
+{
+    DBusServer *s = (DBusServer *)user_data;
     GHashTableIter iter;
-    gpointer k;
-    gpointer v;
+    gpointer val;
+
+    g_hash_table_iter_init(&iter, s->clients);
+    while (g_hash_table_iter_next(&iter, NULL, &val)) {
+        Client *c = (Client *)val;
+        if (c->progress && elapsed % c->progress == 0)
+            emit_to_client(c, "InactiveProgress",
+                    g_variant_new("(u)", elapsed));
+    }
+}
 
-    g_hash_table_iter_init(&iter, s->inhibitors);
+/* Progress is driven by one timeline timeout, the shortest interval of any
+ * client, after which a single shared source wakes only when some client's
+ * interval is due. */
+static void
+update_progress(DBusServer *s)
+{
+    guint min = progress_min_interval(s->progress);
 
-    while (g_hash_table_iter_next(&iter, &k, &v))
-        g_variant_builder_add(&b, "{s@(tss)}", k, v);
+    if (min == s->progress_timeout)
+        return;
 
-    dict = g_variant_builder_end(&b);
-    dbus_session_complete_list_inhibitors(session, i, dict);
+    if (s->progress_timeout)
+        g_signal_emit(s, signals[REMOVE_TIMEOUT_SIGNAL], 0,
+                s->progress_timeout);
+    s->progress_timeout = min;
+    if (min)
+        g_signal_emit(s, signals[ADD_TIMEOUT_SIGNAL], 0, min);
+}
 
-    g_variant_ref_sink(dict);
-    g_variant_unref(dict);
+static gboolean
+on_handle_set_inactive_progress(DBusSession *session,
+        GDBusMethodInvocation *i, guint sec, gpointer user_data)
+{
+    DBusServer *s = (DBusServer *)user_data;
+    Client *c = sec ? get_client(s, i) : lookup_client(s, i);
+
+    if (c) {
+        if (c->progress)
+            progress_remove_interval(s->progress, c->progress);
+        c->progress = sec;
+        if (sec)
+            progress_add_interval(s->progress, sec);
+        update_progress(s);
+        release_client(c);
+    }
+
+    dbus_session_complete_set_inactive_progress(session, i);
 
     return TRUE;
 }
 
+static void
+emit_event(Client *c, const struct Event *ev)
+{
+    emit_to_client(c, "Event", g_variant_new("(tsv)", ev->seq, ev->name,
+                ev->data));
+}
+
+/* Replay kept events from from_seq, then send new events as they are
+ * recorded. Returns the sequence number of the first event replayed, which is
+ * greater than from_seq if events were lost. */
+static gboolean
+on_handle_subscribe(DBusSession *session, GDBusMethodInvocation *i,
+        guint64 from_seq, gpointer user_data)
+{
+    DBusServer *s = (DBusServer *)user_data;
+    Client *c = get_client(s, i);
+    guint64 first = MAX(from_seq, events_first_seq(s->events));
+    const struct Event *ev;
+
+    c->subscribed = TRUE;
+
+    for (guint64 seq = first; (ev = events_get(s->events, seq)); seq++)
+        emit_event(c, ev);
+
+    dbus_session_complete_subscribe(session, i,
+            MIN(first, s->events->next_seq));
+
+    return TRUE;
+}
+
+static gboolean
+on_handle_unsubscribe(DBusSession *session, GDBusMethodInvocation *i,
+        gpointer user_data)
+{
+    Client *c = lookup_client((DBusServer *)user_data, i);
+
+    if (c) {
+        c->subscribed = FALSE;
+        release_client(c);
+    }
+
+    dbus_session_complete_unsubscribe(session, i);
+
+    return TRUE;
+}
+
+/* Record an event and send it to subscribers. A floating data reference is
+ * sunk. */
+void
+dbus_server_push_event(DBusServer *s, const gchar *name, GVariant *data)
+{
+    const struct Event *ev = events_push(s->events, name, data);
+    GHashTableIter iter;
+    gpointer val;
+
+    g_hash_table_iter_init(&iter, s->clients);
+    while (g_hash_table_iter_next(&iter, NULL, &val))
+        if (((Client *)val)->subscribed)
+            emit_event(val, ev);
+}
+
+static void
+export_on_peer(gpointer skeleton, GDBusConnection *conn, const gchar *path)
+{
+    GError *err = NULL;
+
+    g_dbus_interface_skeleton_export(G_DBUS_INTERFACE_SKELETON(skeleton),
+            conn, path, &err);
+    if (err) {
+        g_warning("Failed to export %s to peer: %s", path, err->message);
+        g_error_free(err);
+    }
+}
+
+static void
+unexport_on_peer(gpointer skeleton, GDBusConnection *conn)
+{
+    GDBusInterfaceSkeleton *skel = G_DBUS_INTERFACE_SKELETON(skeleton);
+
+    if (g_dbus_interface_skeleton_has_connection(skel, conn))
+        g_dbus_interface_skeleton_unexport_from_connection(skel, conn);
+}
+
+/* Objects other than the session are exported through the object manager so
+ * that clients can fetch them all with GetManagedObjects. */
+void
+dbus_server_export_object(DBusServer *s, gpointer skeleton, const gchar *path)
+{
+    GDBusObjectSkeleton *obj = g_dbus_object_skeleton_new(path);
+
+    g_dbus_object_skeleton_add_interface(obj,
+            G_DBUS_INTERFACE_SKELETON(skeleton));
+    g_dbus_object_manager_server_export(s->manager, obj);
+    g_object_unref(obj);
+
+    for (guint i = 0; i < s->peers->len; i++)
+        export_on_peer(skeleton, g_ptr_array_index(s->peers, i), path);
+}
+
+void
+dbus_server_unexport_object(DBusServer *s, gpointer skeleton)
+{
+    const gchar *path = SKELETON_PATH(skeleton);
+
+    if (!path)
+        return;
+
+    for (guint i = 0; i < s->peers->len; i++)
+        unexport_on_peer(skeleton, g_ptr_array_index(s->peers, i));
+
+    g_dbus_object_manager_server_unexport(s->manager, path);
+}
+
+/* Paths of exported backlights, backlight groups and audio sinks are kept in NULL-terminated
+ * arrays backing the session's properties, so exporting or unexporting one
+ * object does not rebuild them. Order is not preserved on removal. */
+static GPtrArray *
+new_paths(void)
+{
+    GPtrArray *paths = g_ptr_array_new_with_free_func(g_free);
+    g_ptr_array_add(paths, NULL);
+    return paths;
+}
+
+void
+dbus_server_add_path(GPtrArray *paths, const gchar *path)
+{
+    g_ptr_array_insert(paths, paths->len - 1, g_strdup(path));
+}
+
+void
+dbus_server_remove_path(GPtrArray *paths, const gchar *path)
+{
+    for (guint i = 0; i + 1 < paths->len; i++) {
+        if (g_strcmp0(g_ptr_array_index(paths, i), path) != 0)
+            continue;
+
+        guint last = paths->len - 2;
+        gpointer p = paths->pdata[i];
+
+        paths->pdata[i] = paths->pdata[last];
+        paths->pdata[last] = p;
+        g_ptr_array_remove_index(paths, last);
+        return;
+    }
+}
+
+static void
+set_paths_properties(DBusServer *s)
+{
+    dbus_session_set_backlights(s->session,
+            (const gchar *const *)s->backlight_paths->pdata);
+    dbus_session_set_backlight_groups(s->session,
+            (const gchar *const *)s->backlight_group_paths->pdata);
+#ifdef WIREPLUMBER
+    dbus_session_set_audio_sinks(s->session,
+            (const gchar *const *)s->audiosink_paths->pdata);
+#endif /* WIREPLUMBER */
+}
+
+#define THROTTLE_KEY "sessiond-throttle"
+
+/* Property updates of an object are applied by func, at most once per
+ * properties interval, so that bursts of changes are sent as one
+ * PropertiesChanged signal. The throttle is freed with the skeleton. */
+void
+dbus_server_throttle_object(DBusServer *s, gpointer skeleton,
+        ThrottleFunc func, gpointer user_data, GDestroyNotify notify)
+{
+    Throttle *t = throttle_new(s->properties_interval, func, user_data,
+            notify);
+    g_object_set_data_full(G_OBJECT(skeleton), THROTTLE_KEY, t,
+            (GDestroyNotify)throttle_free);
+}
+
+Throttle *
+dbus_server_get_throttle(gpointer skeleton)
+{
+    return g_object_get_data(G_OBJECT(skeleton), THROTTLE_KEY);
+}
+
+void
+dbus_server_set_properties_interval(DBusServer *s, guint interval)
+{
+    GHashTableIter iter;
+    gpointer val;
+
+    s->properties_interval = interval;
+
+#define SET_INTERVAL(table) \
+    g_hash_table_iter_init(&iter, table); \
+    while (g_hash_table_iter_next(&iter, NULL, &val)) \
+        throttle_set_interval(dbus_server_get_throttle(val), interval)
+    SET_INTERVAL(s->backlights);
+#ifdef WIREPLUMBER
+    SET_INTERVAL(s->audiosinks);
+#endif /* WIREPLUMBER */
+#undef SET_INTERVAL
+}
+
+static GVariant *
+build_state(DBusServer *s)
+{
+    GVariantBuilder state;
+    GVariantBuilder arr;
+    GHashTableIter iter;
+    gpointer val;
+
+    g_variant_builder_init(&state, G_VARIANT_TYPE_VARDICT);
+
+#define ADD(k, t, v) \
+    g_variant_builder_add(&state, "{sv}", k, g_variant_new(t, v))
+    ADD("InhibitedHint", "b",
+            dbus_session_get_inhibited_hint(s->session));
+    ADD("LockedHint", "b", dbus_session_get_locked_hint(s->session));
+    ADD("IdleHint", "b", dbus_session_get_idle_hint(s->session));
+    ADD("IdleSinceHint", "t", dbus_session_get_idle_since_hint(s->session));
+
+    g_variant_builder_init(&arr, G_VARIANT_TYPE("a(osuu)"));
+    g_hash_table_iter_init(&iter, s->backlights);
+    while (g_hash_table_iter_next(&iter, NULL, &val)) {
+        DBusBacklight *dbl = (DBusBacklight *)val;
+        if (!EXPORTED(dbl))
+            continue;
+        g_variant_builder_add(&arr, "(osuu)", SKELETON_PATH(dbl),
+                dbus_backlight_get_name(dbl),
+                dbus_backlight_get_brightness(dbl),
+                dbus_backlight_get_max_brightness(dbl));
+    }
+    ADD("Backlights", "a(osuu)", &arr);
+
+#ifdef WIREPLUMBER
+    g_variant_builder_init(&arr, G_VARIANT_TYPE("a(osdb)"));
+    g_hash_table_iter_init(&iter, s->audiosinks);
+    while (g_hash_table_iter_next(&iter, NULL, &val)) {
+        DBusAudioSink *das = (DBusAudioSink *)val;
+        const gchar *name = dbus_audio_sink_get_name(das);
+        if (!EXPORTED(das))
+            continue;
+        g_variant_builder_add(&arr, "(osdb)", SKELETON_PATH(das),
+                name ? name : "", dbus_audio_sink_get_volume(das),
+                dbus_audio_sink_get_mute(das));
+    }
+    ADD("AudioSinks", "a(osdb)", &arr);
+
+    const gchar *sink = dbus_session_get_default_audio_sink(s->session);
+    if (sink)
+        ADD("DefaultAudioSink", "o", sink);
+#endif /* WIREPLUMBER */
+#undef ADD
+
+    return g_variant_ref_sink(g_variant_builder_end(&state));
+}
+
+/* The reply is built once and reused until a property of the session or of
+ * an exported object changes. */
+static gboolean
+on_handle_get_state(DBusSession *session, GDBusMethodInvocation *i,
+        gpointer user_data)
+{
+    DBusServer *s = (DBusServer *)user_data;
+
+    if (!s->state)
+        s->state = build_state(s);
+
+    dbus_session_complete_get_state(session, i, s->state);
+
+    return TRUE;
+}
+
+/* Mirror the session hints and every exported backlight and audio sink in
+ * the state file. */
+static void
+write_state_file(DBusServer *s)
+{
+    struct sessiond_state *st = s->state_file->state;
+    GHashTableIter iter;
+    gpointer val;
+    guint n = 0;
+
+    state_file_begin(s->state_file);
+
+    st->flags = SESSIOND_STATE_RUNNING;
+    if (dbus_session_get_idle_hint(s->session))
+        st->flags |= SESSIOND_STATE_IDLE;
+    if (dbus_session_get_locked_hint(s->session))
+        st->flags |= SESSIOND_STATE_LOCKED;
+    if (dbus_session_get_inhibited_hint(s->session))
+        st->flags |= SESSIOND_STATE_INHIBITED;
+    st->idle_since_hint = dbus_session_get_idle_since_hint(s->session);
+
+    g_hash_table_iter_init(&iter, s->backlights);
+    while (n < SESSIOND_STATE_MAX_BACKLIGHTS
+            && g_hash_table_iter_next(&iter, NULL, &val)) {
+        DBusBacklight *dbl = (DBusBacklight *)val;
+        struct sessiond_state_backlight *b = &st->backlights[n];
+        if (!EXPORTED(dbl))
+            continue;
+        g_strlcpy(b->name, dbus_backlight_get_name(dbl), sizeof(b->name));
+        b->brightness = dbus_backlight_get_brightness(dbl);
+        b->max_brightness = dbus_backlight_get_max_brightness(dbl);
+        n++;
+    }
+    st->n_backlights = n;
+
+    n = 0;
+    st->default_audiosink = -1;
+#ifdef WIREPLUMBER
+    const gchar *sink = dbus_session_get_default_audio_sink(s->session);
+
+    g_hash_table_iter_init(&iter, s->audiosinks);
+    while (n < SESSIOND_STATE_MAX_AUDIOSINKS
+            && g_hash_table_iter_next(&iter, NULL, &val)) {
+        DBusAudioSink *das = (DBusAudioSink *)val;
+        struct sessiond_state_audiosink *a = &st->audiosinks[n];
+        const gchar *name = dbus_audio_sink_get_name(das);
+        if (!EXPORTED(das))
+            continue;
+        g_strlcpy(a->name, name ? name : "", sizeof(a->name));
+        a->id = dbus_audio_sink_get_id(das);
+        a->mute = dbus_audio_sink_get_mute(das);
+        a->volume = dbus_audio_sink_get_volume(das);
+        if (g_strcmp0(sink, SKELETON_PATH(das)) == 0)
+            st->default_audiosink = n;
+        n++;
+    }
+#endif /* WIREPLUMBER */
+    st->n_audiosinks = n;
+
+    state_file_end(s->state_file);
+}
+
+/* Called whenever a property of the session or an exported object changes
+ * or an object is unexported. */
+void
+dbus_server_invalidate_state(DBusServer *s)
+{
+    if (s->state) {
+        g_variant_unref(s->state);
+        s->state = NULL;
+    }
+
+    if (s->state_file && s->session)
+        write_state_file(s);
+}
+
+static void
+on_state_notify(UNUSED GObject *obj, UNUSED GParamSpec *pspec,
+        gpointer user_data)
+{
+    dbus_server_invalidate_state((DBusServer *)user_data);
+}
+
+void
+dbus_server_watch_state(DBusServer *s, gpointer skeleton)
+{
+    g_signal_connect(skeleton, "notify", G_CALLBACK(on_state_notify), s);
+}
+
 static void
 lock_callback(LogindContext *c, gboolean state, gpointer data)
 {
@@ -212,6 +993,7 @@ lock_callback(LogindContext *c, gboolean state, gpointer data)
         dbus_session_emit_lock(s->session);
     else
         dbus_session_emit_unlock(s->session);
+    dbus_server_push_event(s, "Lock", g_variant_new("(b)", state));
 }
 
 static void
@@ -221,6 +1003,7 @@ sleep_callback(UNUSED LogindContext *c, gboolean state, gpointer data)
     if (!EXPORTED(s->session))
         return;
     dbus_session_emit_prepare_for_sleep(s->session, state);
+    dbus_server_push_event(s, "PrepareForSleep", g_variant_new("(b)", state));
 }
 
 static void
@@ -230,38 +1013,32 @@ shutdown_callback(UNUSED LogindContext *c, gboolean state, gpointer data)
     if (!EXPORTED(s->session))
         return;
     dbus_session_emit_prepare_for_shutdown(s->session, state);
+    dbus_server_push_event(s, "PrepareForShutdown",
+            g_variant_new("(b)", state));
 }
 
 static void
-on_properties_changed(UNUSED GDBusProxy *proxy, GVariant *props,
-        UNUSED GStrv inv_props, gpointer user_data)
+on_properties_changed(LogindContext *c, guint props, gpointer user_data)
 {
     DBusServer *s = (DBusServer *)user_data;
     if (!EXPORTED(s->session))
         return;
-    LogindContext *c = s->ctx;
-    gchar *prop = NULL;
-    GVariantIter iter;
-
-    g_variant_iter_init(&iter, props);
-
-    while (g_variant_iter_loop(&iter, "{sv}", &prop, NULL)) {
-        if (g_strcmp0(prop, "LockedHint") == 0) {
-            dbus_session_set_locked_hint(s->session,
-                    logind_get_locked_hint(c));
-        } else if (g_strcmp0(prop, "IdleHint") == 0) {
-            gboolean idle = logind_get_idle_hint(c);
-            dbus_session_set_idle_hint(s->session, idle);
-            if (idle)
-                dbus_session_emit_idle(s->session);
-        } else if (g_strcmp0(prop, "IdleSinceHint") == 0) {
-            dbus_session_set_idle_since_hint(s->session,
-                    logind_get_idle_since_hint(c));
-        } else if (g_strcmp0(prop, "IdleSinceHintMonotonic") == 0) {
-            dbus_session_set_idle_since_hint_monotonic(s->session,
-                    logind_get_idle_since_hint_monotonic(c));
-        }
+
+    if (props & LOGIND_PROPERTY_LOCKED_HINT)
+        dbus_session_set_locked_hint(s->session, logind_get_locked_hint(c));
+    if (props & LOGIND_PROPERTY_IDLE_HINT) {
+        gboolean idle = logind_get_idle_hint(c);
+        dbus_session_set_idle_hint(s->session, idle);
+        if (idle)
+            dbus_session_emit_idle(s->session);
+        dbus_server_push_event(s, "Idle", g_variant_new("(b)", idle));
     }
+    if (props & LOGIND_PROPERTY_IDLE_SINCE_HINT)
+        dbus_session_set_idle_since_hint(s->session,
+                logind_get_idle_since_hint(c));
+    if (props & LOGIND_PROPERTY_IDLE_SINCE_HINT_MONOTONIC)
+        dbus_session_set_idle_since_hint_monotonic(s->session,
+                logind_get_idle_since_hint_monotonic(c));
 }
 
 static void
@@ -270,7 +1047,7 @@ init_properties(DBusServer *s)
     LogindContext *c = s->ctx;
 
     dbus_session_set_inhibited_hint(s->session,
-            g_hash_table_size(s->inhibitors) > 0);
+            inhibitors_size(s->inhibitors) > 0);
     dbus_session_set_locked_hint(s->session, logind_get_locked_hint(c));
     dbus_session_set_idle_hint(s->session, logind_get_idle_hint(c));
     dbus_session_set_idle_since_hint(s->session, logind_get_idle_since_hint(c));
@@ -280,6 +1057,169 @@ init_properties(DBusServer *s)
     dbus_session_set_version(s->session, VERSION);
 }
 
+typedef void (*PeerFunc)(gpointer skeleton, GDBusConnection *conn);
+
+/* Call func with the session and every exported object. */
+static void
+foreach_peer_skeleton(DBusServer *s, PeerFunc func, GDBusConnection *conn)
+{
+    GHashTable *tables[] = {
+        s->backlights,
+        s->backlight_groups,
+#ifdef WIREPLUMBER
+        s->audiosinks,
+#endif /* WIREPLUMBER */
+    };
+    GHashTableIter iter;
+    gpointer val;
+
+    func(s->session, conn);
+
+    for (guint i = 0; i < G_N_ELEMENTS(tables); i++) {
+        g_hash_table_iter_init(&iter, tables[i]);
+        while (g_hash_table_iter_next(&iter, NULL, &val))
+            if (EXPORTED(val))
+                func(val, conn);
+    }
+}
+
+static void
+export_skeleton_on_peer(gpointer skeleton, GDBusConnection *conn)
+{
+    export_on_peer(skeleton, conn, SKELETON_PATH(skeleton));
+}
+
+static void
+drop_peer(DBusServer *s, GDBusConnection *conn)
+{
+    foreach_peer_skeleton(s, unexport_on_peer, conn);
+    g_signal_handlers_disconnect_by_data(conn, s);
+    g_ptr_array_remove(s->peers, conn);
+}
+
+static void
+on_peer_closed(GDBusConnection *conn, UNUSED gboolean remote,
+        UNUSED GError *err, gpointer user_data)
+{
+    g_debug("Peer connection closed");
+    drop_peer((DBusServer *)user_data, conn);
+}
+
+static gboolean
+on_new_peer(UNUSED GDBusServer *server, GDBusConnection *conn,
+        gpointer user_data)
+{
+    DBusServer *s = (DBusServer *)user_data;
+
+    g_debug("Peer connection opened");
+
+    g_ptr_array_add(s->peers, g_object_ref(conn));
+    g_signal_connect(conn, "closed", G_CALLBACK(on_peer_closed), s);
+    foreach_peer_skeleton(s, export_skeleton_on_peer, conn);
+
+    return TRUE;
+}
+
+static gboolean
+on_peer_allow_mechanism(UNUSED GDBusAuthObserver *o, const gchar *mechanism,
+        UNUSED gpointer user_data)
+{
+    return g_strcmp0(mechanism, "EXTERNAL") == 0;
+}
+
+/* Only processes of the same user may connect. */
+static gboolean
+on_peer_authorize(UNUSED GDBusAuthObserver *o, UNUSED GIOStream *stream,
+        GCredentials *credentials, UNUSED gpointer user_data)
+{
+    return credentials
+        && g_credentials_get_unix_user(credentials, NULL) == getuid();
+}
+
+/* Listen for peer-to-peer connections on a socket in the user's runtime
+ * directory, exporting the same objects as on the bus. JSON requests on the
+ * control socket are forwarded over a peer connection. */
+static void
+start_peer_server(DBusServer *s)
+{
+    if (s->peer_server)
+        return;
+
+    gchar *path = g_build_filename(g_get_user_runtime_dir(), DBUS_PEER_SOCKET,
+            NULL);
+    gchar *dir = g_path_get_dirname(path);
+
+    if (g_mkdir_with_parents(dir, 0700) == -1) {
+        g_warning("Failed to create %s", dir);
+        g_free(dir);
+        g_free(path);
+        return;
+    }
+    g_free(dir);
+    g_unlink(path);
+
+    gchar *address = g_strconcat("unix:path=", path, NULL);
+    gchar *guid = g_dbus_generate_guid();
+    GDBusAuthObserver *observer = g_dbus_auth_observer_new();
+    GError *err = NULL;
+
+    g_signal_connect(observer, "allow-mechanism",
+            G_CALLBACK(on_peer_allow_mechanism), NULL);
+    g_signal_connect(observer, "authorize-authenticated-peer",
+            G_CALLBACK(on_peer_authorize), NULL);
+
+    s->peer_server = g_dbus_server_new_sync(address, G_DBUS_SERVER_FLAGS_NONE,
+            guid, observer, NULL, &err);
+
+    g_object_unref(observer);
+    g_free(guid);
+    g_free(address);
+
+    if (err) {
+        g_warning("Failed to listen on %s: %s", path, err->message);
+        g_error_free(err);
+        g_free(path);
+        return;
+    }
+
+    s->peer_path = path;
+    g_signal_connect(s->peer_server, "new-connection",
+            G_CALLBACK(on_new_peer), s);
+    g_dbus_server_start(s->peer_server);
+
+    g_debug("Listening for peers on %s", path);
+
+    gchar *ctl_path = g_build_filename(g_get_user_runtime_dir(), CTL_SOCKET,
+            NULL);
+    s->ctl_server = ctl_server_new(ctl_path,
+            g_dbus_server_get_client_address(s->peer_server));
+    g_free(ctl_path);
+}
+
+static void
+stop_peer_server(DBusServer *s)
+{
+    if (!s->peer_server)
+        return;
+
+    ctl_server_free(s->ctl_server);
+    s->ctl_server = NULL;
+
+    g_dbus_server_stop(s->peer_server);
+    g_object_unref(s->peer_server);
+    s->peer_server = NULL;
+
+    while (s->peers->len) {
+        GDBusConnection *conn = g_ptr_array_index(s->peers, 0);
+        g_dbus_connection_close(conn, NULL, NULL, NULL);
+        drop_peer(s, conn);
+    }
+
+    g_unlink(s->peer_path);
+    g_free(s->peer_path);
+    s->peer_path = NULL;
+}
+
 static void
 on_name_acquired(GDBusConnection *conn, const gchar *name, gpointer user_data)
 {
@@ -303,20 +1243,40 @@ on_name_acquired(GDBusConnection *conn, const gchar *name, gpointer user_data)
     g_signal_connect(session, "handle-unlock", G_CALLBACK(on_handle_unlock), s);
     g_signal_connect(session, "handle-inhibit",
             G_CALLBACK(on_handle_inhibit), s);
+    g_signal_connect(session, "handle-inhibit-for",
+            G_CALLBACK(on_handle_inhibit_for), s);
+    g_signal_connect(session, "handle-inhibit-fd",
+            G_CALLBACK(on_handle_inhibit_fd), s);
     g_signal_connect(session, "handle-uninhibit",
             G_CALLBACK(on_handle_uninhibit), s);
     g_signal_connect(session, "handle-stop-inhibitors",
             G_CALLBACK(on_handle_stop_inhibitors), s);
     g_signal_connect(session, "handle-list-inhibitors",
             G_CALLBACK(on_handle_list_inhibitors), s);
+    g_signal_connect(session, "handle-get-inhibitor-expiries",
+            G_CALLBACK(on_handle_get_inhibitor_expiries), s);
+    g_signal_connect(session, "handle-get-state",
+            G_CALLBACK(on_handle_get_state), s);
+    g_signal_connect(session, "handle-add-inactive-timeout",
+            G_CALLBACK(on_handle_add_inactive_timeout), s);
+    g_signal_connect(session, "handle-remove-inactive-timeout",
+            G_CALLBACK(on_handle_remove_inactive_timeout), s);
+    g_signal_connect(session, "handle-set-inactive-progress",
+            G_CALLBACK(on_handle_set_inactive_progress), s);
+    g_signal_connect(session, "handle-subscribe",
+            G_CALLBACK(on_handle_subscribe), s);
+    g_signal_connect(session, "handle-unsubscribe",
+            G_CALLBACK(on_handle_unsubscribe), s);
 
     g_signal_connect_after(c, "lock", G_CALLBACK(lock_callback), s);
     g_signal_connect_after(c, "sleep", G_CALLBACK(sleep_callback), s);
     g_signal_connect_after(c, "shutdown", G_CALLBACK(shutdown_callback), s);
 
-    g_signal_connect(c->logind_session, "g-properties-changed",
+    g_signal_connect(c, "properties-changed",
             G_CALLBACK(on_properties_changed), s);
     init_properties(s);
+    dbus_server_watch_state(s, session);
+    dbus_server_invalidate_state(s);
 
     GError *err = NULL;
     g_dbus_interface_skeleton_export(G_DBUS_INTERFACE_SKELETON(session),
@@ -327,21 +1287,30 @@ on_name_acquired(GDBusConnection *conn, const gchar *name, gpointer user_data)
         err = NULL;
     }
 
-    GList *lst;
+    g_dbus_object_manager_server_set_connection(s->manager, conn);
+
+    /* Array properties are set once after all objects are exported. */
+    GHashTableIter iter;
+    gpointer val;
+    s->exporting = TRUE;
 #define EXPORT_TABLE(name) \
-    lst = g_hash_table_get_values(s->name##s); \
-    for (GList *i = lst; i; i = i->next) \
-        if (!EXPORTED(i->data)) \
-            dbus_server_export_##name(s, i->data); \
-    g_list_free(lst)
+    g_hash_table_iter_init(&iter, s->name##s); \
+    while (g_hash_table_iter_next(&iter, NULL, &val)) \
+        if (!EXPORTED(val)) \
+            dbus_server_export_##name(s, val)
 
     EXPORT_TABLE(backlight);
+    EXPORT_TABLE(backlight_group);
 
 #ifdef WIREPLUMBER
     EXPORT_TABLE(audiosink);
 #endif /* WIREPLUMBER */
 
 #undef EXPORT_TABLE
+    s->exporting = FALSE;
+    set_paths_properties(s);
+
+    start_peer_server(s);
 }
 
 static void
@@ -352,22 +1321,33 @@ on_name_lost(GDBusConnection *conn, const gchar *name, gpointer user_data)
     DBusServer *s = (DBusServer *)user_data;
     s->name_acquired = FALSE;
 
+    /* Handlers on the logind context are connected again when the name is
+     * acquired. */
+    g_signal_handlers_disconnect_by_data(s->ctx, s);
+    dbus_server_clear_clients(s);
+    stop_peer_server(s);
     g_dbus_interface_skeleton_unexport(G_DBUS_INTERFACE_SKELETON(s->session));
 
-    GList *lst;
+    GHashTableIter iter;
+    gpointer val;
+    s->exporting = TRUE;
 #define UNEXPORT_TABLE(name) \
-    lst = g_hash_table_get_values(s->name##s); \
-    for (GList *i = lst; i; i = i->next) \
-        dbus_server_unexport_##name(s, i->data); \
-    g_list_free(lst)
+    g_hash_table_iter_init(&iter, s->name##s); \
+    while (g_hash_table_iter_next(&iter, NULL, &val)) \
+        dbus_server_unexport_##name(s, val)
 
     UNEXPORT_TABLE(backlight);
+    UNEXPORT_TABLE(backlight_group);
 
 #ifdef WIREPLUMBER
     UNEXPORT_TABLE(audiosink);
 #endif /* WIREPLUMBER */
 
 #undef UNEXPORT_TABLE
+    s->exporting = FALSE;
+    set_paths_properties(s);
+
+    g_dbus_object_manager_server_set_connection(s->manager, NULL);
 
     s->bus_id = 0;
 }
@@ -379,13 +1359,32 @@ dbus_server_free(DBusServer *s)
         return;
     if (s->bus_id)
         g_bus_unown_name(s->bus_id);
+    g_signal_handlers_disconnect_by_data(s->ctx, s);
+    stop_peer_server(s);
+    s->state_file = NULL;
+    dbus_server_invalidate_state(s);
     if (s->session)
         g_object_unref(s->session);
+    /* Releases the shared progress timeout along with client timeouts. */
+    dbus_server_clear_clients(s);
+    g_hash_table_destroy(s->clients);
+    progress_free(s->progress);
+    events_free(s->events);
     g_hash_table_destroy(s->backlights);
-    g_hash_table_destroy(s->inhibitors);
+    g_ptr_array_unref(s->backlight_paths);
+    g_hash_table_destroy(s->backlight_groups);
+    g_ptr_array_unref(s->backlight_group_paths);
+    g_object_unref(s->manager);
+    g_ptr_array_unref(s->peers);
+    if (s->expiry_source) {
+        g_source_destroy(s->expiry_source);
+        g_source_unref(s->expiry_source);
+    }
+    inhibitors_free(s->inhibitors);
 
 #ifdef WIREPLUMBER
     g_hash_table_destroy(s->audiosinks);
+    g_ptr_array_unref(s->audiosink_paths);
 #endif /* WIREPLUMBER */
 
     g_object_unref(s);
@@ -402,6 +1401,12 @@ dbus_server_class_init(DBusServerClass *s)
     signals[UNINHIBIT_SIGNAL] = g_signal_new("uninhibit",
             type, G_SIGNAL_RUN_LAST, 0, NULL, NULL, NULL, G_TYPE_NONE, 3,
             G_TYPE_STRING, G_TYPE_STRING, G_TYPE_UINT);
+    signals[ADD_TIMEOUT_SIGNAL] = g_signal_new("add-timeout",
+            type, G_SIGNAL_RUN_LAST, 0, NULL, NULL, NULL, G_TYPE_NONE, 1,
+            G_TYPE_UINT);
+    signals[REMOVE_TIMEOUT_SIGNAL] = g_signal_new("remove-timeout",
+            type, G_SIGNAL_RUN_LAST, 0, NULL, NULL, NULL, G_TYPE_NONE, 1,
+            G_TYPE_UINT);
 }
 
 static void
@@ -414,15 +1419,58 @@ dbus_server_emit_active(DBusServer *s)
 {
     if (!s || !EXPORTED(s->session))
         return;
+    progress_stop(s->progress);
     dbus_session_emit_active(s->session);
+    dbus_server_push_event(s, "Active", g_variant_new("()"));
 }
 
+/* Timeouts registered over DBus are signalled only to the clients that
+ * registered them. Configured timeouts are broadcast unless disabled, in
+ * which case they too reach only the clients that registered them. */
 void
-dbus_server_emit_inactive(DBusServer *s, guint i)
+dbus_server_emit_inactive(DBusServer *s, guint i, gboolean configured)
 {
     if (!s || !EXPORTED(s->session))
         return;
-    dbus_session_emit_inactive(s->session, i);
+
+    if (i == s->progress_timeout)
+        progress_start(s->progress);
+
+    if (configured) {
+        dbus_server_push_event(s, "Inactive", g_variant_new("(u)", i));
+        if (s->broadcast_inactive) {
+            dbus_session_emit_inactive(s->session, i);
+            return;
+        }
+    }
+
+    GHashTableIter iter;
+    gpointer val;
+
+    g_hash_table_iter_init(&iter, s->clients);
+    while (g_hash_table_iter_next(&iter, NULL, &val)) {
+        Client *c = (Client *)val;
+        if (g_hash_table_contains(c->timeouts, GUINT_TO_POINTER(i)))
+            emit_to_client(c, "Inactive", g_variant_new("(u)", i));
+    }
+}
+
+/* Stop inactive progress while inactivity is not being counted, such as when
+ * the session is inhibited or the timeline is restarted. */
+void
+dbus_server_stop_progress(DBusServer *s)
+{
+    if (s)
+        progress_stop(s->progress);
+}
+
+/* Drop all client registrations and subscriptions, emitting remove-timeout
+ * for each timeout. */
+void
+dbus_server_clear_clients(DBusServer *s)
+{
+    g_hash_table_remove_all(s->clients);
+    update_progress(s);
 }
 
 DBusServer *
@@ -431,15 +1479,37 @@ dbus_server_new(LogindContext *c)
     DBusServer *s = g_object_new(DBUS_TYPE_SERVER, NULL);
 
     s->ctx = c;
+    s->manager = g_dbus_object_manager_server_new(DBUS_PATH);
+    s->peer_server = NULL;
+    s->peer_path = NULL;
+    s->peers = g_ptr_array_new_with_free_func(g_object_unref);
+    s->ctl_server = NULL;
     s->bl_devices = NULL;
+    s->bl_group_confs = NULL;
+    s->exporting = FALSE;
     s->backlights = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
             g_object_unref);
-    s->inhibitors = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
-            (GDestroyNotify)g_variant_unref);
+    s->backlight_paths = new_paths();
+    s->backlight_groups = g_hash_table_new_full(g_str_hash, g_str_equal,
+            g_free, g_object_unref);
+    s->backlight_group_paths = new_paths();
+    s->inhibitors = inhibitors_new();
+    s->expiry_source = NULL;
+    s->expiry_time = -1;
+    s->state = NULL;
+    s->state_file = NULL;
+    s->properties_interval = 0;
+    s->broadcast_inactive = TRUE;
+    s->progress_timeout = 0;
+    s->progress = progress_new(NULL, on_progress, s);
+    s->clients = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+            (GDestroyNotify)free_client);
+    s->events = events_new(DBUS_EVENTS_SIZE);
 
 #ifdef WIREPLUMBER
     s->audiosinks = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
             g_object_unref);
+    s->audiosink_paths = new_paths();
 #endif /* WIREPLUMBER */
 
     s->bus_id = g_bus_own_name(G_BUS_TYPE_SESSION, DBUS_NAME,
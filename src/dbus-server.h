@@ -20,6 +20,12 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 #include "dbus-logind.h"
 #include "dbus-gen.h"
 #include "backlight.h"
+#include "inhibitors.h"
+#include "throttle.h"
+#include "state-file.h"
+#include "events.h"
+#include "progress.h"
+#include "ctl-server.h"
 
 #ifdef WIREPLUMBER
 #include "wireplumber.h"
@@ -30,6 +36,8 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 #define DBUS_NAME "org.sessiond.session1"
 #define DBUS_SESSION_ERROR DBUS_NAME ".Session.Error"
 #define DBUS_PATH "/org/sessiond/session1"
+#define DBUS_PEER_SOCKET "sessiond/bus"
+#define DBUS_EVENTS_SIZE 256
 
 #define DBUS_TYPE_SERVER dbus_server_get_type()
 G_DECLARE_FINAL_TYPE(DBusServer, dbus_server, DBUS, SERVER, GObject);
@@ -40,14 +48,35 @@ struct _DBusServer {
     GDBusConnection *conn;
     gboolean name_acquired;
     DBusSession *session;
+    GDBusObjectManagerServer *manager;
+    GDBusServer *peer_server;
+    gchar *peer_path;
+    GPtrArray *peers;
+    CtlServer *ctl_server;
     LogindContext *ctx;
-    GHashTable *inhibitors;
+    Inhibitors *inhibitors;
+    GSource *expiry_source;
+    gint64 expiry_time;
+    GHashTable *clients;
+    Events *events;
+    GVariant *state;
+    StateFile *state_file;
+    guint properties_interval;
+    gboolean broadcast_inactive;
+    guint progress_timeout;
+    Progress *progress;
+    gboolean exporting;
     GHashTable *backlights;
+    GPtrArray *backlight_paths;
+    GHashTable *backlight_groups;
+    GPtrArray *backlight_group_paths;
     GHashTable *bl_devices;
+    GHashTable *bl_group_confs;
 
 #ifdef WIREPLUMBER
     WpConn *wp_conn;
     GHashTable *audiosinks;
+    GPtrArray *audiosink_paths;
 #endif /* WIREPLUMBER */
 };
 
@@ -56,6 +85,35 @@ dbus_server_free(DBusServer *s);
 extern void
 dbus_server_emit_active(DBusServer *s);
 extern void
-dbus_server_emit_inactive(DBusServer *s, guint i);
+dbus_server_emit_inactive(DBusServer *s, guint i, gboolean configured);
+extern void
+dbus_server_stop_progress(DBusServer *s);
+extern void
+dbus_server_clear_clients(DBusServer *s);
+extern gchar *
+dbus_server_inhibit(DBusServer *s, const gchar *who, const gchar *why);
+extern void
+dbus_server_uninhibit(DBusServer *s, const gchar *id);
+extern void
+dbus_server_push_event(DBusServer *s, const gchar *name, GVariant *data);
+extern void
+dbus_server_export_object(DBusServer *s, gpointer skeleton, const gchar *path);
+extern void
+dbus_server_unexport_object(DBusServer *s, gpointer skeleton);
+extern void
+dbus_server_add_path(GPtrArray *paths, const gchar *path);
+extern void
+dbus_server_remove_path(GPtrArray *paths, const gchar *path);
+extern void
+dbus_server_throttle_object(DBusServer *s, gpointer skeleton,
+        ThrottleFunc func, gpointer user_data, GDestroyNotify notify);
+extern Throttle *
+dbus_server_get_throttle(gpointer skeleton);
+extern void
+dbus_server_set_properties_interval(DBusServer *s, guint interval);
+extern void
+dbus_server_invalidate_state(DBusServer *s);
+extern void
+dbus_server_watch_state(DBusServer *s, gpointer skeleton);
 extern DBusServer *
 dbus_server_new(LogindContext *c);
@@ -28,6 +28,75 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 #define SYSTEMD_MANAGER_IFACE SYSTEMD_NAME ".Manager"
 #define SYSTEMD_PATH "/org/freedesktop/systemd1"
 
+/* Milliseconds to wait for systemd to reply to a method call. */
+#define SYSTEMD_CALL_TIMEOUT 5000
+
+typedef struct {
+    gchar *unit;
+    gchar *path;
+    guint64 seq;
+    gint64 start;
+} SystemdJob;
+
+typedef struct {
+    SystemdContext *ctx;
+    gchar *unit;
+    guint64 seq;
+} SystemdStartCall;
+
+static void
+free_job(SystemdJob *job)
+{
+    g_free(job->unit);
+    g_free(job->path);
+    g_free(job);
+}
+
+static void
+systemd_on_signal(UNUSED GDBusProxy *proxy, UNUSED gchar *sender,
+                  gchar *signal, GVariant *params, gpointer user_data)
+{
+    SystemdContext *c = (SystemdContext *)user_data;
+
+    if (g_strcmp0(signal, "JobRemoved") != 0)
+        return;
+
+    guint32 id;
+    const gchar *path;
+    const gchar *unit;
+    const gchar *result;
+
+    g_variant_get(params, "(u&o&s&s)", &id, &path, &unit, &result);
+
+    SystemdJob *job = g_hash_table_lookup(c->jobs, unit);
+
+    if (!job || g_strcmp0(job->path, path) != 0)
+        return;
+
+    g_debug("Job %u for unit %s %s in %" G_GINT64_FORMAT "ms", id, unit,
+            result, (g_get_monotonic_time() - job->start) / 1000);
+
+    g_hash_table_remove(c->jobs, unit);
+}
+
+static void
+systemd_on_subscribe(GObject *source, GAsyncResult *res,
+                     UNUSED gpointer user_data)
+{
+    GError *err = NULL;
+    GVariant *v = g_dbus_proxy_call_finish(G_DBUS_PROXY(source), res, &err);
+
+    if (err) {
+        if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            g_warning("Failed to subscribe to %s: %s", SYSTEMD_NAME,
+                      err->message);
+        g_error_free(err);
+        return;
+    }
+
+    g_variant_unref(v);
+}
+
 static void
 systemd_on_appear(GDBusConnection *conn, const gchar *name, const gchar *owner,
                   gpointer user_data)
@@ -38,14 +107,22 @@ systemd_on_appear(GDBusConnection *conn, const gchar *name, const gchar *owner,
     GError *err = NULL;
 
     c->systemd_manager = g_dbus_proxy_new_sync(
-        conn, G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES |
-        G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS, NULL, SYSTEMD_NAME,
+        conn, G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES, NULL, SYSTEMD_NAME,
         SYSTEMD_PATH, SYSTEMD_MANAGER_IFACE, NULL, &err);
 
     if (err) {
         g_warning("%s", err->message);
         g_error_free(err);
+        return;
     }
+
+    g_signal_connect(c->systemd_manager, "g-signal",
+                     G_CALLBACK(systemd_on_signal), c);
+
+    /* JobRemoved is only emitted to subscribed clients. */
+    g_dbus_proxy_call(c->systemd_manager, "Subscribe", NULL,
+                      G_DBUS_CALL_FLAGS_NONE, SYSTEMD_CALL_TIMEOUT,
+                      c->cancellable, systemd_on_subscribe, c);
 }
 
 static void
@@ -56,6 +133,47 @@ systemd_on_vanish(UNUSED GDBusConnection *conn, const gchar *name,
     systemd_context_free((SystemdContext *)user_data);
 }
 
+static void
+systemd_on_start_unit(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    SystemdStartCall *call = (SystemdStartCall *)user_data;
+    GError *err = NULL;
+    GVariant *v = g_dbus_proxy_call_finish(G_DBUS_PROXY(source), res, &err);
+
+    /* The context is gone if its calls were cancelled. */
+    if (g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        g_error_free(err);
+        goto end;
+    }
+
+    SystemdJob *job = g_hash_table_lookup(call->ctx->jobs, call->unit);
+
+    if (!job || job->seq != call->seq)
+        job = NULL;
+
+    if (err) {
+        g_warning("Failed to start unit %s: %s", call->unit, err->message);
+        g_error_free(err);
+        if (job)
+            g_hash_table_remove(call->ctx->jobs, call->unit);
+        goto end;
+    }
+
+    g_debug("Started unit %s", call->unit);
+
+    if (job)
+        g_variant_get(v, "(o)", &job->path);
+    g_variant_unref(v);
+
+end:
+    g_free(call->unit);
+    g_free(call);
+}
+
+/* Start a unit asynchronously. The start is skipped if the last unit started
+ * was this one and its job is still pending; any other start in between may
+ * have cancelled that job, since units such as graphical-lock.target and
+ * graphical-unlock.target conflict. */
 void
 systemd_start_unit(SystemdContext *c, const gchar *name)
 {
@@ -65,17 +183,29 @@ systemd_start_unit(SystemdContext *c, const gchar *name)
         return;
     }
 
-    GError *err = NULL;
-    g_dbus_proxy_call_sync(c->systemd_manager, "StartUnit",
-                           g_variant_new("(ss)", name, "replace"),
-                           G_DBUS_CALL_FLAGS_NONE, -1, NULL, &err);
+    SystemdJob *job = g_hash_table_lookup(c->jobs, name);
 
-    if (err) {
-        g_warning("%s", err->message);
-        g_error_free(err);
-    } else {
-        g_debug("Started unit %s", name);
+    if (job && job->seq == c->seq) {
+        g_debug("Skipping start of unit %s: job already pending", name);
+        return;
     }
+
+    job = g_malloc0(sizeof(SystemdJob));
+    job->unit = g_strdup(name);
+    job->seq = ++c->seq;
+    job->start = g_get_monotonic_time();
+
+    g_hash_table_replace(c->jobs, job->unit, job);
+
+    SystemdStartCall *call = g_malloc(sizeof(SystemdStartCall));
+    call->ctx = c;
+    call->unit = g_strdup(name);
+    call->seq = job->seq;
+
+    g_dbus_proxy_call(c->systemd_manager, "StartUnit",
+                      g_variant_new("(ss)", name, "replace"),
+                      G_DBUS_CALL_FLAGS_NONE, SYSTEMD_CALL_TIMEOUT,
+                      c->cancellable, systemd_on_start_unit, call);
 }
 
 SystemdContext *
@@ -83,6 +213,10 @@ systemd_context_new(void)
 {
     SystemdContext *c = g_malloc0(sizeof(SystemdContext));
 
+    c->jobs = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+            (GDestroyNotify)free_job);
+    c->cancellable = g_cancellable_new();
+
     c->systemd_watcher = g_bus_watch_name(
         G_BUS_TYPE_SESSION, SYSTEMD_NAME, G_BUS_NAME_WATCHER_FLAGS_NONE,
         systemd_on_appear, systemd_on_vanish, c, NULL);
@@ -103,5 +237,8 @@ systemd_context_free(SystemdContext *c)
         g_object_unref(c->systemd_manager);
         c->systemd_manager = NULL;
     }
+    g_cancellable_cancel(c->cancellable);
+    g_object_unref(c->cancellable);
+    g_hash_table_unref(c->jobs);
     g_free(c);
 }
@@ -23,6 +23,9 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 typedef struct {
     guint systemd_watcher;
     GDBusProxy *systemd_manager;
+    GHashTable *jobs;
+    guint64 seq;
+    GCancellable *cancellable;
 } SystemdContext;
 
 extern void
@@ -0,0 +1,86 @@
+/*
+sessiond - standalone X session manager
+Copyright (C) 2018-2020 James Reed
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#define G_LOG_DOMAIN "sessiond"
+
+#include "events.h"
+
+#include <glib-2.0/glib.h>
+
+#define SLOT(e, seq) (&(e)->ring[(seq) % (e)->size])
+
+Events *
+events_new(guint size)
+{
+    g_return_val_if_fail(size > 0, NULL);
+
+    Events *e = g_malloc(sizeof(Events));
+    e->ring = g_malloc0_n(size, sizeof(struct Event));
+    e->size = size;
+    e->next_seq = 1;
+
+    return e;
+}
+
+void
+events_free(Events *e)
+{
+    if (!e)
+        return;
+
+    for (guint i = 0; i < e->size; i++)
+        if (e->ring[i].data)
+            g_variant_unref(e->ring[i].data);
+
+    g_free(e->ring);
+    g_free(e);
+}
+
+/* name must be a static string. A floating data reference is sunk. */
+const struct Event *
+events_push(Events *e, const gchar *name, GVariant *data)
+{
+    struct Event *ev = SLOT(e, e->next_seq);
+
+    if (ev->data)
+        g_variant_unref(ev->data);
+
+    ev->seq = e->next_seq++;
+    ev->time = g_get_real_time();
+    ev->name = name;
+    ev->data = g_variant_ref_sink(data);
+
+    return ev;
+}
+
+/* Returns NULL if the event has been overwritten or does not exist yet. */
+const struct Event *
+events_get(Events *e, guint64 seq)
+{
+    if (seq < events_first_seq(e) || seq >= e->next_seq)
+        return NULL;
+
+    return SLOT(e, seq);
+}
+
+/* The sequence number of the oldest event kept, or of the next event if none
+ * has been pushed. */
+guint64
+events_first_seq(Events *e)
+{
+    return e->next_seq > e->size ? e->next_seq - e->size : 1;
+}
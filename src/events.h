@@ -0,0 +1,47 @@
+/*
+sessiond - standalone X session manager
+Copyright (C) 2018-2020 James Reed
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <glib-2.0/glib.h>
+
+struct Event {
+    guint64 seq;
+    gint64 time;
+    const gchar *name;
+    GVariant *data;
+};
+
+/* A fixed-size ring of recent events. Sequence numbers start at 1 and
+ * increase by one for each event; an event is found at seq % size until it is
+ * overwritten. */
+typedef struct {
+    struct Event *ring;
+    guint size;
+    guint64 next_seq;
+} Events;
+
+extern Events *
+events_new(guint size);
+extern void
+events_free(Events *e);
+extern const struct Event *
+events_push(Events *e, const gchar *name, GVariant *data);
+extern const struct Event *
+events_get(Events *e, guint64 seq);
+extern guint64
+events_first_seq(Events *e);
@@ -0,0 +1,306 @@
+/*
+sessiond - standalone X session manager
+Copyright (C) 2018-2020 James Reed
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define CTL_SOCKET "sessiond/ctl"
+
+static void
+usage(void)
+{
+    fprintf(stderr, "Usage: sessiond-call [-p PATH] METHOD [ARG...]\n");
+}
+
+static int
+is_number(const char *s)
+{
+    if (*s == '-')
+        s++;
+
+    if (*s == '0')
+        s++;
+    else if (*s >= '1' && *s <= '9')
+        while (*s >= '0' && *s <= '9')
+            s++;
+    else
+        return 0;
+
+    if (*s == '.') {
+        s++;
+        if (*s < '0' || *s > '9')
+            return 0;
+        while (*s >= '0' && *s <= '9')
+            s++;
+    }
+
+    if (*s == 'e' || *s == 'E') {
+        s++;
+        if (*s == '+' || *s == '-')
+            s++;
+        if (*s < '0' || *s > '9')
+            return 0;
+        while (*s >= '0' && *s <= '9')
+            s++;
+    }
+
+    return *s == '\0';
+}
+
+static void
+write_string(FILE *f, const char *s)
+{
+    fputc('"', f);
+
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\')
+            fprintf(f, "\\%c", *s);
+        else if ((unsigned char)*s < 0x20)
+            fprintf(f, "\\u%04x", *s);
+        else
+            fputc(*s, f);
+    }
+
+    fputc('"', f);
+}
+
+/* Arguments that look like JSON values are passed as is, and others as
+ * strings. A leading + is accepted on numbers. */
+static void
+write_arg(FILE *f, const char *arg)
+{
+    if (*arg == '+' && is_number(arg + 1))
+        arg++;
+
+    if (is_number(arg) || strcmp(arg, "true") == 0
+            || strcmp(arg, "false") == 0 || strcmp(arg, "null") == 0
+            || *arg == '[' || *arg == '{' || *arg == '"')
+        fputs(arg, f);
+    else
+        write_string(f, arg);
+}
+
+/* Print a JSON string without quotes, undoing the escapes sessiond uses. */
+static const char *
+print_string(FILE *f, const char *p)
+{
+    for (p++; *p && *p != '"'; p++) {
+        if (*p != '\\') {
+            fputc(*p, f);
+            continue;
+        }
+
+        switch (*++p) {
+        case 'n':
+            fputc('\n', f);
+            break;
+        case 'r':
+            fputc('\r', f);
+            break;
+        case 't':
+            fputc('\t', f);
+            break;
+        case 'u':
+            if (strlen(p) >= 5) {
+                fputc((int)strtol((char[]){p[1], p[2], p[3], p[4], '\0'},
+                            NULL, 16), f);
+                p += 4;
+            }
+            break;
+        case '\0':
+            return p;
+        default:
+            fputc(*p, f);
+        }
+    }
+
+    return p;
+}
+
+/* Print each element of a JSON array on its own line, with strings
+ * unquoted. */
+static void
+print_values(const char *p)
+{
+    while (*p && *p != ']') {
+        const char *start = p;
+        int depth = 0;
+        int str = 0;
+
+        for (; *p; p++) {
+            if (str) {
+                if (*p == '\\' && p[1])
+                    p++;
+                else if (*p == '"')
+                    str = 0;
+            } else if (*p == '"') {
+                str = 1;
+            } else if (*p == '[' || *p == '{') {
+                depth++;
+            } else if (*p == ']' || *p == '}') {
+                if (!depth)
+                    break;
+                depth--;
+            } else if (*p == ',' && !depth) {
+                break;
+            }
+        }
+
+        if (*start == '"')
+            print_string(stdout, start);
+        else
+            fwrite(start, 1, p - start, stdout);
+        putchar('\n');
+
+        if (*p == ',')
+            p++;
+    }
+}
+
+static int
+connect_socket(void)
+{
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    const char *dir = getenv("XDG_RUNTIME_DIR");
+    int fd;
+
+    if (!dir || !*dir) {
+        fprintf(stderr, "XDG_RUNTIME_DIR is not set\n");
+        return -1;
+    }
+
+    if (snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/%s", dir,
+                CTL_SOCKET) >= (int)sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long\n");
+        return -1;
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        perror("Failed to create socket");
+        return -1;
+    }
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        fprintf(stderr, "Failed to connect to %s: ", addr.sun_path);
+        perror(NULL);
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+int
+main(int argc, char *argv[])
+{
+    const char *path = NULL;
+    char *req = NULL;
+    size_t req_len = 0;
+    char *line = NULL;
+    size_t n = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "+p:h")) != -1) {
+        switch (opt) {
+        case 'p':
+            path = optarg;
+            break;
+        case 'h':
+            usage();
+            return EXIT_SUCCESS;
+        default:
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (optind >= argc) {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    FILE *f = open_memstream(&req, &req_len);
+
+    fputs("{\"method\":", f);
+    write_string(f, argv[optind]);
+    if (path) {
+        fputs(",\"path\":", f);
+        write_string(f, path);
+    }
+    fputs(",\"parameters\":[", f);
+    for (int i = optind + 1; i < argc; i++) {
+        if (i > optind + 1)
+            fputc(',', f);
+        write_arg(f, argv[i]);
+    }
+    fputs("]}\n", f);
+    fclose(f);
+
+    int fd = connect_socket();
+    if (fd == -1) {
+        free(req);
+        return EXIT_FAILURE;
+    }
+
+    for (size_t off = 0; off < req_len;) {
+        ssize_t w = write(fd, req + off, req_len - off);
+        if (w == -1) {
+            perror("Failed to send request");
+            free(req);
+            close(fd);
+            return EXIT_FAILURE;
+        }
+        off += w;
+    }
+    free(req);
+    shutdown(fd, SHUT_WR);
+
+    FILE *in = fdopen(fd, "r");
+
+    if (getline(&line, &n, in) == -1) {
+        fprintf(stderr, "No reply from sessiond\n");
+        fclose(in);
+        free(line);
+        return EXIT_FAILURE;
+    }
+    fclose(in);
+
+    int ret = EXIT_SUCCESS;
+    const char *p;
+
+    if ((p = strstr(line, "{\"parameters\":["))) {
+        print_values(p + strlen("{\"parameters\":["));
+    } else if ((p = strstr(line, "\"message\":\""))) {
+        print_string(stderr, p + strlen("\"message\":"));
+        fputc('\n', stderr);
+        ret = EXIT_FAILURE;
+    } else {
+        fputs(line, stderr);
+        ret = EXIT_FAILURE;
+    }
+
+    free(line);
+
+    return ret;
+}
@@ -15,39 +15,198 @@ You should have received a copy of the GNU General Public License along with
 this program. If not, see <https://www.gnu.org/licenses/>.
 */
 
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <sys/param.h>
+#include <sys/stat.h>
 
-int
-main(int argc, char *argv[])
+static const char *allowed_subsystems[] = {
+    "/sys/class/backlight",
+    "/sys/class/leds",
+    NULL,
+};
+
+/* Only brightness attributes of backlight and LED class devices may be
+ * written; symlinks are resolved before checking and the canonical path is
+ * stored in real. */
+static int
+path_allowed(const char *path, char *real)
+{
+    char subsystem[MAXPATHLEN];
+    char resolved[MAXPATHLEN];
+    char *name;
+
+    if (!realpath(path, real))
+        return 0;
+
+    name = strrchr(real, '/');
+    if (!name || strcmp(name, "/brightness") != 0)
+        return 0;
+
+    *name = '\0';
+    if (snprintf(subsystem, sizeof(subsystem), "%s/subsystem", real)
+            >= (int)sizeof(subsystem)) {
+        *name = '/';
+        return 0;
+    }
+    *name = '/';
+
+    if (!realpath(subsystem, resolved))
+        return 0;
+
+    for (const char **s = allowed_subsystems; *s; s++)
+        if (strcmp(resolved, *s) == 0)
+            return 1;
+
+    return 0;
+}
+
+/* Open the canonical path without following symlinks, then check that the
+ * file opened is the one that was allowed, so a path swapped after the check
+ * is never written. */
+static int
+open_allowed(const char *real)
+{
+    char fdpath[32];
+    char opened[MAXPATHLEN];
+    struct stat st;
+    ssize_t len;
+    int fd;
+
+    fd = open(real, O_WRONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd == -1)
+        return -1;
+
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode))
+        goto error;
+
+    snprintf(fdpath, sizeof(fdpath), "/proc/self/fd/%d", fd);
+    len = readlink(fdpath, opened, sizeof(opened) - 1);
+    if (len == -1)
+        goto error;
+    opened[len] = '\0';
+
+    if (strcmp(opened, real) == 0)
+        return fd;
+
+    errno = EPERM;
+
+error:
+    close(fd);
+    return -1;
+}
+
+static int
+value_valid(const char *value)
+{
+    if (!*value)
+        return 0;
+
+    for (const char *c = value; *c; c++)
+        if (*c < '0' || *c > '9')
+            return 0;
+
+    return 1;
+}
+
+static int
+write_value(const char *p, const char *value)
 {
     char path[MAXPATHLEN];
-    FILE *f;
+    char real[MAXPATHLEN];
+    size_t len = strlen(value);
+    int fd;
 
-    if (argc != 3) {
-        fprintf(stderr, "Expected 2 arguments: PATH VALUE\n");
-        return EXIT_FAILURE;
+    if (strncmp("/sys", p, 4) == 0)
+        snprintf(path, sizeof(path), "%s", p);
+    else
+        snprintf(path, sizeof(path), "/sys%s", p);
+
+    if (!value_valid(value)) {
+        fprintf(stderr, "Invalid value for %s: %s\n", path, value);
+        return -1;
     }
 
-    if (strncmp("/sys", argv[1], 4) == 0) {
-        f = fopen(argv[1], "w");
-    } else {
-        snprintf(path, sizeof(path), "/sys%s", argv[1]);
-        f = fopen(path, "w");
+    if (!path_allowed(path, real)) {
+        fprintf(stderr, "Path not allowed: %s\n", path);
+        return -1;
     }
 
-    if (!f) {
+    fd = open_allowed(real);
+
+    if (fd == -1) {
         perror("Failed to open path");
-        return EXIT_FAILURE;
+        return -1;
+    }
+
+    if (write(fd, value, len) != (ssize_t)len) {
+        close(fd);
+        fprintf(stderr, "Failed to write to path: %s\n", path);
+        return -1;
     }
 
-    if (fprintf(f, "%s", argv[2]) < 0) {
-        fclose(f);
-        fprintf(stderr, "Failed to write to path\n");
+    if (close(fd) != 0) {
+        perror("Failed to write to path");
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Read "PATH VALUE" lines until EOF. */
+static int
+read_stdin(void)
+{
+    char *line = NULL;
+    size_t n = 0;
+    int ret = EXIT_SUCCESS;
+
+    while (getline(&line, &n, stdin) != -1) {
+        char *save;
+        char *path = strtok_r(line, " \t\n", &save);
+        char *value = strtok_r(NULL, " \t\n", &save);
+
+        if (!path)
+            continue;
+
+        if (!value || strtok_r(NULL, " \t\n", &save)) {
+            fprintf(stderr, "Expected line of format: PATH VALUE\n");
+            ret = EXIT_FAILURE;
+            continue;
+        }
+
+        if (write_value(path, value) == -1)
+            ret = EXIT_FAILURE;
+    }
+
+    free(line);
+
+    return ret;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int ret = EXIT_SUCCESS;
+
+    if (argc == 2 && strcmp(argv[1], "--stdin") == 0)
+        return read_stdin();
+
+    if (argc < 3 || argc % 2 == 0) {
+        fprintf(stderr, "Expected arguments: PATH VALUE [PATH VALUE...]\n"
+                "               or: --stdin\n");
         return EXIT_FAILURE;
     }
 
-    fclose(f);
+    for (int i = 1; i < argc; i += 2)
+        if (write_value(argv[i], argv[i + 1]) == -1)
+            ret = EXIT_FAILURE;
+
+    return ret;
 }
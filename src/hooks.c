@@ -48,6 +48,18 @@ hooks_add_timeouts(GPtrArray *hooks, Timeline *tl)
     }
 }
 
+gboolean
+hooks_has_timeout(GPtrArray *hooks, guint timeout)
+{
+    for (guint i = 0; i < hooks->len; i++) {
+        struct Hook *h = g_ptr_array_index(hooks, i);
+        if (h->trigger == HOOK_TRIGGER_INACTIVE && h->inactive_sec == timeout)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
 void
 hooks_run(GPtrArray *hooks, HookTrigger trigger, gboolean state)
 {
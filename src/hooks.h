@@ -50,6 +50,8 @@ struct Hook {
 
 extern void
 hooks_add_timeouts(GPtrArray *hooks, Timeline *tl);
+extern gboolean
+hooks_has_timeout(GPtrArray *hooks, guint timeout);
 extern void
 hooks_run(GPtrArray *hooks, HookTrigger trigger, gboolean state);
 extern void
@@ -0,0 +1,267 @@
+/*
+sessiond - standalone X session manager
+Copyright (C) 2018-2020 James Reed
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#define G_LOG_DOMAIN "sessiond"
+
+#include "inhibitors.h"
+#include "common.h"
+
+#include <unistd.h>
+#include <glib-2.0/glib.h>
+
+static void
+unlink_inhibitor(Inhibitors *s, struct Inhibitor *i);
+
+static void
+invalidate(Inhibitors *s)
+{
+    g_clear_pointer(&s->cached, g_variant_unref);
+    g_clear_pointer(&s->cached_expiries, g_variant_unref);
+}
+
+Inhibitors *
+inhibitors_new(void)
+{
+    Inhibitors *s = g_malloc0(sizeof(Inhibitors));
+
+    s->by_id = g_hash_table_new(g_str_hash, g_str_equal);
+    s->expiries = g_sequence_new(NULL);
+    g_queue_init(&s->list);
+
+    return s;
+}
+
+void
+inhibitors_free(Inhibitors *s)
+{
+    if (!s)
+        return;
+
+    struct Inhibitor *i;
+    while ((i = inhibitors_pop(s)))
+        inhibitor_free(i);
+
+    g_hash_table_unref(s->by_id);
+    g_sequence_free(s->expiries);
+    invalidate(s);
+    g_free(s);
+}
+
+struct Inhibitor *
+inhibitors_add(Inhibitors *s, const gchar *who, const gchar *why)
+{
+    struct Inhibitor *i = g_malloc0(sizeof(struct Inhibitor));
+
+    i->id = g_uuid_string_random();
+    i->who = g_ref_string_new_intern(who);
+    i->why = g_ref_string_new_intern(why);
+    i->timestamp = g_get_real_time();
+    i->fd = -1;
+    i->link.data = i;
+
+    g_hash_table_insert(s->by_id, i->id, i);
+    g_queue_push_tail_link(&s->list, &i->link);
+
+    invalidate(s);
+
+    return i;
+}
+
+static gint
+compare_expiry(gconstpointer a, gconstpointer b, UNUSED gpointer user_data)
+{
+    gint64 ea = ((const struct Inhibitor *)a)->expiry;
+    gint64 eb = ((const struct Inhibitor *)b)->expiry;
+
+    return (ea > eb) - (ea < eb);
+}
+
+/* Expire the inhibitor at the given monotonic time, or never if 0. */
+void
+inhibitors_set_expiry(Inhibitors *s, struct Inhibitor *i, gint64 expiry)
+{
+    if (i->expiry_iter) {
+        g_sequence_remove(i->expiry_iter);
+        i->expiry_iter = NULL;
+    }
+
+    i->expiry = expiry;
+
+    if (expiry)
+        i->expiry_iter = g_sequence_insert_sorted(s->expiries, i,
+                compare_expiry, NULL);
+
+    invalidate(s);
+}
+
+/* Expire the inhibitor sec seconds after the monotonic time now, or never if
+ * sec is 0. */
+void
+inhibitors_set_timeout(Inhibitors *s, struct Inhibitor *i, gint64 now,
+        guint sec)
+{
+    inhibitors_set_expiry(s, i, sec ? now + (gint64)sec * G_USEC_PER_SEC : 0);
+}
+
+/* Returns the earliest expiry, or -1 if no inhibitor has one. */
+gint64
+inhibitors_next_expiry(Inhibitors *s)
+{
+    GSequenceIter *iter = g_sequence_get_begin_iter(s->expiries);
+
+    if (g_sequence_iter_is_end(iter))
+        return -1;
+
+    return ((struct Inhibitor *)g_sequence_get(iter))->expiry;
+}
+
+/* Remove an inhibitor that has expired by now, if any. */
+struct Inhibitor *
+inhibitors_pop_expired(Inhibitors *s, gint64 now)
+{
+    gint64 next = inhibitors_next_expiry(s);
+
+    if (next == -1 || next > now)
+        return NULL;
+
+    struct Inhibitor *i = g_sequence_get(g_sequence_get_begin_iter(
+                s->expiries));
+    unlink_inhibitor(s, i);
+
+    return i;
+}
+
+struct Inhibitor *
+inhibitors_lookup(Inhibitors *s, const gchar *id)
+{
+    return g_hash_table_lookup(s->by_id, id);
+}
+
+static void
+unlink_inhibitor(Inhibitors *s, struct Inhibitor *i)
+{
+    g_hash_table_remove(s->by_id, i->id);
+    g_queue_unlink(&s->list, &i->link);
+
+    if (i->expiry_iter) {
+        g_sequence_remove(i->expiry_iter);
+        i->expiry_iter = NULL;
+    }
+
+    invalidate(s);
+}
+
+/* Remove an inhibitor from the store, returning it to be freed by the
+ * caller. */
+struct Inhibitor *
+inhibitors_steal(Inhibitors *s, const gchar *id)
+{
+    struct Inhibitor *i = inhibitors_lookup(s, id);
+
+    if (i)
+        unlink_inhibitor(s, i);
+
+    return i;
+}
+
+/* Remove the oldest inhibitor. */
+struct Inhibitor *
+inhibitors_pop(Inhibitors *s)
+{
+    GList *l = g_queue_peek_head_link(&s->list);
+
+    if (!l)
+        return NULL;
+
+    struct Inhibitor *i = l->data;
+    unlink_inhibitor(s, i);
+
+    return i;
+}
+
+guint
+inhibitors_size(Inhibitors *s)
+{
+    return s->list.length;
+}
+
+/* Returns a{s(tss)} owned by the store, mapping IDs to the timestamp, who and
+ * why. */
+GVariant *
+inhibitors_list(Inhibitors *s)
+{
+    if (s->cached)
+        return s->cached;
+
+    GVariantBuilder b;
+    g_variant_builder_init(&b, G_VARIANT_TYPE("a{s(tss)}"));
+
+    for (GList *l = s->list.head; l; l = l->next) {
+        struct Inhibitor *i = l->data;
+        g_variant_builder_add(&b, "{s(tss)}", i->id, i->timestamp, i->who,
+                i->why);
+    }
+
+    s->cached = g_variant_ref_sink(g_variant_builder_end(&b));
+
+    return s->cached;
+}
+
+/* Returns a{st} owned by the store, mapping the IDs of inhibitors with an
+ * expiry to the seconds remaining before it, rounded up. */
+GVariant *
+inhibitors_list_expiries(Inhibitors *s)
+{
+    gint64 now = g_get_monotonic_time();
+    gint64 sec = now / G_USEC_PER_SEC;
+
+    if (s->cached_expiries && s->cached_sec == sec)
+        return s->cached_expiries;
+
+    g_clear_pointer(&s->cached_expiries, g_variant_unref);
+
+    GVariantBuilder b;
+    g_variant_builder_init(&b, G_VARIANT_TYPE("a{st}"));
+
+    GSequenceIter *iter = g_sequence_get_begin_iter(s->expiries);
+    for (; !g_sequence_iter_is_end(iter); iter = g_sequence_iter_next(iter)) {
+        struct Inhibitor *i = g_sequence_get(iter);
+        guint64 remaining = (MAX(i->expiry - now, 0) + G_USEC_PER_SEC - 1)
+            / G_USEC_PER_SEC;
+        g_variant_builder_add(&b, "{st}", i->id, remaining);
+    }
+
+    s->cached_expiries = g_variant_ref_sink(g_variant_builder_end(&b));
+    s->cached_sec = sec;
+
+    return s->cached_expiries;
+}
+
+void
+inhibitor_free(struct Inhibitor *i)
+{
+    if (!i)
+        return;
+    if (i->fd_watch)
+        g_source_remove(i->fd_watch);
+    if (i->fd != -1)
+        close(i->fd);
+    g_free(i->id);
+    g_ref_string_release(i->who);
+    g_ref_string_release(i->why);
+    g_free(i);
+}
@@ -0,0 +1,79 @@
+/*
+sessiond - standalone X session manager
+Copyright (C) 2018-2020 James Reed
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <glib-2.0/glib.h>
+
+struct Inhibitor {
+    gchar *id;
+    GRefString *who;
+    GRefString *why;
+    gint64 timestamp;
+    gint64 expiry;
+    GSequenceIter *expiry_iter;
+    gint fd;
+    guint fd_watch;
+    GList link;
+};
+
+/* Inhibitors indexed by ID, kept in the order they were added. They are not
+ * indexed by sender, as they are not released when their client disconnects.
+ * Inhibitors with an expiry are also kept sorted by expiry. The
+ * ListInhibitors value is cached until the store is modified. The
+ * GetInhibitorExpiries value is also rebuilt when the second changes. */
+typedef struct {
+    GHashTable *by_id;
+    GQueue list;
+    GSequence *expiries;
+    GVariant *cached;
+    GVariant *cached_expiries;
+    gint64 cached_sec;
+} Inhibitors;
+
+/* Longest duration accepted by InhibitFor. */
+#define INHIBITOR_MAX_SEC (365 * 24 * 60 * 60)
+
+extern Inhibitors *
+inhibitors_new(void);
+extern void
+inhibitors_free(Inhibitors *s);
+extern struct Inhibitor *
+inhibitors_add(Inhibitors *s, const gchar *who, const gchar *why);
+extern void
+inhibitors_set_expiry(Inhibitors *s, struct Inhibitor *i, gint64 expiry);
+extern void
+inhibitors_set_timeout(Inhibitors *s, struct Inhibitor *i, gint64 now,
+        guint sec);
+extern gint64
+inhibitors_next_expiry(Inhibitors *s);
+extern struct Inhibitor *
+inhibitors_pop_expired(Inhibitors *s, gint64 now);
+extern struct Inhibitor *
+inhibitors_lookup(Inhibitors *s, const gchar *id);
+extern struct Inhibitor *
+inhibitors_steal(Inhibitors *s, const gchar *id);
+extern struct Inhibitor *
+inhibitors_pop(Inhibitors *s);
+extern guint
+inhibitors_size(Inhibitors *s);
+extern GVariant *
+inhibitors_list(Inhibitors *s);
+extern GVariant *
+inhibitors_list_expiries(Inhibitors *s);
+extern void
+inhibitor_free(struct Inhibitor *i);
@@ -0,0 +1,749 @@
+/*
+sessiond - standalone X session manager
+Copyright (C) 2018-2020 James Reed
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#define G_LOG_DOMAIN "sessiond"
+
+#include "json.h"
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <glib-2.0/glib.h>
+
+#define JSON_MAX_DEPTH 64
+
+#define IS_NULL(v) \
+    (g_variant_is_of_type(v, G_VARIANT_TYPE("mv")) \
+     && g_variant_n_children(v) == 0)
+
+G_DEFINE_QUARK(json-error-quark, json_error)
+
+typedef struct {
+    const gchar *start;
+    const gchar *p;
+    guint depth;
+    GError **err;
+} Parser;
+
+static GVariant *
+parse_value(Parser *ps);
+
+static GVariant *
+parse_error(Parser *ps, const gchar *msg)
+{
+    g_set_error(ps->err, JSON_ERROR, JSON_ERROR_PARSE, "%s at offset %ld", msg,
+            (glong)(ps->p - ps->start));
+    return NULL;
+}
+
+static void
+skip_space(Parser *ps)
+{
+    while (*ps->p == ' ' || *ps->p == '\t' || *ps->p == '\n'
+            || *ps->p == '\r')
+        ps->p++;
+}
+
+static gboolean
+parse_literal(Parser *ps, const gchar *lit)
+{
+    gsize len = strlen(lit);
+
+    if (strncmp(ps->p, lit, len) != 0)
+        return FALSE;
+
+    ps->p += len;
+
+    return TRUE;
+}
+
+static gboolean
+parse_hex4(const gchar *p, gunichar *c)
+{
+    *c = 0;
+
+    for (guint i = 0; i < 4; i++) {
+        gint d = g_ascii_xdigit_value(p[i]);
+        if (d == -1)
+            return FALSE;
+        *c = (*c << 4) | d;
+    }
+
+    return TRUE;
+}
+
+/* Surrogate pairs are joined; NUL characters are rejected since they cannot
+ * appear in GVariant strings. */
+static gchar *
+parse_string(Parser *ps)
+{
+    GString *str = g_string_new(NULL);
+    gunichar u, lo;
+
+    ps->p++;
+
+    for (;;) {
+        gchar c = *ps->p;
+
+        if (c == '"') {
+            ps->p++;
+            return g_string_free(str, FALSE);
+        }
+
+        if ((guchar)c < 0x20)
+            goto invalid;
+
+        ps->p++;
+
+        if (c != '\\') {
+            g_string_append_c(str, c);
+            continue;
+        }
+
+        switch (*ps->p++) {
+        case '"':
+            g_string_append_c(str, '"');
+            break;
+        case '\\':
+            g_string_append_c(str, '\\');
+            break;
+        case '/':
+            g_string_append_c(str, '/');
+            break;
+        case 'b':
+            g_string_append_c(str, '\b');
+            break;
+        case 'f':
+            g_string_append_c(str, '\f');
+            break;
+        case 'n':
+            g_string_append_c(str, '\n');
+            break;
+        case 'r':
+            g_string_append_c(str, '\r');
+            break;
+        case 't':
+            g_string_append_c(str, '\t');
+            break;
+        case 'u':
+            if (!parse_hex4(ps->p, &u))
+                goto invalid;
+            ps->p += 4;
+            if (u >= 0xd800 && u < 0xdc00) {
+                if (ps->p[0] != '\\' || ps->p[1] != 'u'
+                        || !parse_hex4(ps->p + 2, &lo)
+                        || lo < 0xdc00 || lo >= 0xe000)
+                    goto invalid;
+                ps->p += 6;
+                u = 0x10000 + ((u - 0xd800) << 10) + (lo - 0xdc00);
+            } else if ((u >= 0xdc00 && u < 0xe000) || u == 0) {
+                goto invalid;
+            }
+            g_string_append_unichar(str, u);
+            break;
+        default:
+            goto invalid;
+        }
+    }
+
+invalid:
+    g_string_free(str, TRUE);
+    parse_error(ps, "Invalid string");
+    return NULL;
+}
+
+/* Numbers without a fraction or exponent that fit in 64 bits are parsed as
+ * integers, others as doubles. */
+static GVariant *
+parse_number(Parser *ps)
+{
+    const gchar *start = ps->p;
+    gboolean integer = TRUE;
+
+    if (*ps->p == '-')
+        ps->p++;
+
+    if (*ps->p == '0')
+        ps->p++;
+    else if (g_ascii_isdigit(*ps->p))
+        while (g_ascii_isdigit(*ps->p))
+            ps->p++;
+    else
+        return parse_error(ps, "Invalid number");
+
+    if (*ps->p == '.') {
+        integer = FALSE;
+        ps->p++;
+        if (!g_ascii_isdigit(*ps->p))
+            return parse_error(ps, "Invalid number");
+        while (g_ascii_isdigit(*ps->p))
+            ps->p++;
+    }
+
+    if (*ps->p == 'e' || *ps->p == 'E') {
+        integer = FALSE;
+        ps->p++;
+        if (*ps->p == '+' || *ps->p == '-')
+            ps->p++;
+        if (!g_ascii_isdigit(*ps->p))
+            return parse_error(ps, "Invalid number");
+        while (g_ascii_isdigit(*ps->p))
+            ps->p++;
+    }
+
+    if (integer) {
+        errno = 0;
+        gint64 n = g_ascii_strtoll(start, NULL, 10);
+        if (errno != ERANGE)
+            return g_variant_new_int64(n);
+    }
+
+    return g_variant_new_double(g_ascii_strtod(start, NULL));
+}
+
+static GVariant *
+parse_object(Parser *ps)
+{
+    GVariantBuilder b;
+
+    g_variant_builder_init(&b, G_VARIANT_TYPE_VARDICT);
+    ps->p++;
+    skip_space(ps);
+
+    if (*ps->p == '}') {
+        ps->p++;
+        return g_variant_builder_end(&b);
+    }
+
+    for (;;) {
+        skip_space(ps);
+        if (*ps->p != '"')
+            goto invalid;
+
+        gchar *key = parse_string(ps);
+        if (!key)
+            goto error;
+
+        skip_space(ps);
+        if (*ps->p != ':') {
+            g_free(key);
+            goto invalid;
+        }
+        ps->p++;
+
+        GVariant *val = parse_value(ps);
+        if (!val) {
+            g_free(key);
+            goto error;
+        }
+
+        g_variant_builder_add(&b, "{sv}", key, val);
+        g_free(key);
+
+        skip_space(ps);
+        if (*ps->p == '}') {
+            ps->p++;
+            return g_variant_builder_end(&b);
+        }
+        if (*ps->p != ',')
+            goto invalid;
+        ps->p++;
+    }
+
+invalid:
+    parse_error(ps, "Invalid object");
+error:
+    g_variant_builder_clear(&b);
+    return NULL;
+}
+
+static GVariant *
+parse_array(Parser *ps)
+{
+    GVariantBuilder b;
+
+    g_variant_builder_init(&b, G_VARIANT_TYPE("av"));
+    ps->p++;
+    skip_space(ps);
+
+    if (*ps->p == ']') {
+        ps->p++;
+        return g_variant_builder_end(&b);
+    }
+
+    for (;;) {
+        GVariant *val = parse_value(ps);
+        if (!val)
+            goto error;
+
+        g_variant_builder_add_value(&b, g_variant_new_variant(val));
+
+        skip_space(ps);
+        if (*ps->p == ']') {
+            ps->p++;
+            return g_variant_builder_end(&b);
+        }
+        if (*ps->p != ',') {
+            parse_error(ps, "Invalid array");
+            goto error;
+        }
+        ps->p++;
+    }
+
+error:
+    g_variant_builder_clear(&b);
+    return NULL;
+}
+
+static GVariant *
+parse_value(Parser *ps)
+{
+    GVariant *v = NULL;
+    gchar *str;
+
+    skip_space(ps);
+
+    switch (*ps->p) {
+    case '{':
+    case '[':
+        if (ps->depth == JSON_MAX_DEPTH)
+            return parse_error(ps, "Too deeply nested");
+        ps->depth++;
+        v = *ps->p == '{' ? parse_object(ps) : parse_array(ps);
+        ps->depth--;
+        return v;
+    case '"':
+        str = parse_string(ps);
+        return str ? g_variant_new_take_string(str) : NULL;
+    case 't':
+        if (parse_literal(ps, "true"))
+            return g_variant_new_boolean(TRUE);
+        break;
+    case 'f':
+        if (parse_literal(ps, "false"))
+            return g_variant_new_boolean(FALSE);
+        break;
+    case 'n':
+        if (parse_literal(ps, "null"))
+            return g_variant_new_maybe(G_VARIANT_TYPE_VARIANT, NULL);
+        break;
+    default:
+        if (*ps->p == '-' || g_ascii_isdigit(*ps->p))
+            return parse_number(ps);
+        break;
+    }
+
+    return parse_error(ps, "Unexpected character");
+}
+
+/* Parse a JSON document into a GVariant: objects become a{sv}, arrays av,
+ * strings s, numbers x or d, booleans b, and null an empty mv. Returns a new
+ * reference or NULL on error. */
+GVariant *
+json_parse(const gchar *str, GError **err)
+{
+    Parser ps = {str, str, 0, err};
+
+    if (!g_utf8_validate(str, -1, NULL)) {
+        g_set_error(err, JSON_ERROR, JSON_ERROR_PARSE, "Invalid UTF-8");
+        return NULL;
+    }
+
+    GVariant *v = parse_value(&ps);
+    if (!v)
+        return NULL;
+
+    g_variant_ref_sink(v);
+
+    skip_space(&ps);
+    if (*ps.p) {
+        g_variant_unref(v);
+        return parse_error(&ps, "Trailing characters");
+    }
+
+    return v;
+}
+
+static GVariant *
+type_error(const GVariantType *type, GError **err)
+{
+    gchar *str = g_variant_type_dup_string(type);
+
+    g_set_error(err, JSON_ERROR, JSON_ERROR_TYPE, "Expected value of type %s",
+            str);
+    g_free(str);
+
+    return NULL;
+}
+
+static GVariant *
+convert_basic(GVariant *v, const GVariantType *type, GError **err)
+{
+    gchar t = *g_variant_type_peek_string(type);
+    gint64 n;
+
+    if (g_variant_is_of_type(v, G_VARIANT_TYPE_STRING)) {
+        const gchar *str = g_variant_get_string(v, NULL);
+
+        switch (t) {
+        case 's':
+            return g_variant_new_string(str);
+        case 'o':
+            if (g_variant_is_object_path(str))
+                return g_variant_new_object_path(str);
+            break;
+        case 'g':
+            if (g_variant_is_signature(str))
+                return g_variant_new_signature(str);
+            break;
+        }
+
+        return type_error(type, err);
+    }
+
+    if (g_variant_is_of_type(v, G_VARIANT_TYPE_BOOLEAN)) {
+        if (t == 'b')
+            return g_variant_new_boolean(g_variant_get_boolean(v));
+        return type_error(type, err);
+    }
+
+    if (g_variant_is_of_type(v, G_VARIANT_TYPE_INT64)) {
+        n = g_variant_get_int64(v);
+        if (t == 'd')
+            return g_variant_new_double(n);
+    } else if (g_variant_is_of_type(v, G_VARIANT_TYPE_DOUBLE)) {
+        gdouble d = g_variant_get_double(v);
+        if (t == 'd')
+            return g_variant_new_double(d);
+        if (d != floor(d) || d < G_MININT64 || d >= -(gdouble)G_MININT64)
+            return type_error(type, err);
+        n = d;
+    } else {
+        return type_error(type, err);
+    }
+
+#define RANGE(min, max, ctor) \
+    if (n < (min) || n > (max)) \
+        break; \
+    return ctor(n)
+
+    switch (t) {
+    case 'y':
+        RANGE(0, G_MAXUINT8, g_variant_new_byte);
+    case 'n':
+        RANGE(G_MININT16, G_MAXINT16, g_variant_new_int16);
+    case 'q':
+        RANGE(0, G_MAXUINT16, g_variant_new_uint16);
+    case 'i':
+        RANGE(G_MININT32, G_MAXINT32, g_variant_new_int32);
+    case 'u':
+        RANGE(0, G_MAXUINT32, g_variant_new_uint32);
+    case 'x':
+        return g_variant_new_int64(n);
+    case 't':
+        RANGE(0, G_MAXINT64, g_variant_new_uint64);
+    }
+
+#undef RANGE
+
+    return type_error(type, err);
+}
+
+static GVariant *
+convert_tuple(GVariant *v, const GVariantType *type, GError **err)
+{
+    if (!g_variant_is_of_type(v, G_VARIANT_TYPE("av"))
+            || g_variant_n_children(v) != g_variant_type_n_items(type))
+        return type_error(type, err);
+
+    GVariantBuilder b;
+    const GVariantType *t = g_variant_type_first(type);
+
+    g_variant_builder_init(&b, type);
+
+    for (gsize i = 0; t; i++, t = g_variant_type_next(t)) {
+        GVariant *child = g_variant_get_child_value(v, i);
+        GVariant *conv = json_convert(child, t, err);
+
+        g_variant_unref(child);
+        if (!conv) {
+            g_variant_builder_clear(&b);
+            return NULL;
+        }
+        g_variant_builder_add_value(&b, conv);
+    }
+
+    return g_variant_builder_end(&b);
+}
+
+static GVariant *
+convert_array(GVariant *v, const GVariantType *type, GError **err)
+{
+    if (!g_variant_is_of_type(v, G_VARIANT_TYPE("av")))
+        return type_error(type, err);
+
+    GVariantBuilder b;
+    const GVariantType *elem = g_variant_type_element(type);
+    gsize n = g_variant_n_children(v);
+
+    g_variant_builder_init(&b, type);
+
+    for (gsize i = 0; i < n; i++) {
+        GVariant *child = g_variant_get_child_value(v, i);
+        GVariant *conv = json_convert(child, elem, err);
+
+        g_variant_unref(child);
+        if (!conv) {
+            g_variant_builder_clear(&b);
+            return NULL;
+        }
+        g_variant_builder_add_value(&b, conv);
+    }
+
+    return g_variant_builder_end(&b);
+}
+
+/* Object keys are converted from strings to the dictionary's key type. */
+static GVariant *
+convert_dict(GVariant *v, const GVariantType *type, GError **err)
+{
+    if (!g_variant_is_of_type(v, G_VARIANT_TYPE_VARDICT))
+        return type_error(type, err);
+
+    GVariantBuilder b;
+    GVariantIter iter;
+    const GVariantType *entry = g_variant_type_element(type);
+    GVariant *key, *val;
+
+    g_variant_builder_init(&b, type);
+    g_variant_iter_init(&iter, v);
+
+    while (g_variant_iter_next(&iter, "{@sv}", &key, &val)) {
+        GVariant *k = convert_basic(key, g_variant_type_key(entry), err);
+        GVariant *conv = k ? json_convert(val, g_variant_type_value(entry),
+                err) : NULL;
+
+        g_variant_unref(key);
+        g_variant_unref(val);
+
+        if (!conv) {
+            if (k)
+                g_variant_unref(g_variant_ref_sink(k));
+            g_variant_builder_clear(&b);
+            return NULL;
+        }
+
+        g_variant_builder_add_value(&b, g_variant_new_dict_entry(k, conv));
+    }
+
+    return g_variant_builder_end(&b);
+}
+
+/* Convert a value returned by json_parse to the given type. Arrays convert to
+ * tuples and arrays, objects to dictionaries, and null to an empty maybe.
+ * Returns a floating reference or NULL on error. */
+GVariant *
+json_convert(GVariant *v, const GVariantType *type, GError **err)
+{
+    if (g_variant_is_of_type(v, G_VARIANT_TYPE_VARIANT)) {
+        GVariant *inner = g_variant_get_variant(v);
+        GVariant *ret = json_convert(inner, type, err);
+        g_variant_unref(inner);
+        return ret;
+    }
+
+    if (g_variant_type_equal(type, G_VARIANT_TYPE_VARIANT))
+        return g_variant_new_variant(v);
+
+    if (g_variant_type_is_maybe(type)) {
+        if (IS_NULL(v))
+            return g_variant_new_maybe(g_variant_type_element(type), NULL);
+
+        GVariant *elem = json_convert(v, g_variant_type_element(type), err);
+        return elem ? g_variant_new_maybe(NULL, elem) : NULL;
+    }
+
+    if (g_variant_type_is_basic(type))
+        return convert_basic(v, type, err);
+
+    if (g_variant_type_is_tuple(type))
+        return convert_tuple(v, type, err);
+
+    if (g_variant_type_is_array(type)) {
+        if (g_variant_type_is_dict_entry(g_variant_type_element(type)))
+            return convert_dict(v, type, err);
+        return convert_array(v, type, err);
+    }
+
+    return type_error(type, err);
+}
+
+static void
+append_string(GString *out, const gchar *str)
+{
+    g_string_append_c(out, '"');
+
+    for (const gchar *c = str; *c; c++) {
+        switch (*c) {
+        case '"':
+            g_string_append(out, "\\\"");
+            break;
+        case '\\':
+            g_string_append(out, "\\\\");
+            break;
+        case '\n':
+            g_string_append(out, "\\n");
+            break;
+        case '\r':
+            g_string_append(out, "\\r");
+            break;
+        case '\t':
+            g_string_append(out, "\\t");
+            break;
+        default:
+            if ((guchar)*c < 0x20)
+                g_string_append_printf(out, "\\u%04x", *c);
+            else
+                g_string_append_c(out, *c);
+        }
+    }
+
+    g_string_append_c(out, '"');
+}
+
+static void
+append_children(GString *out, GVariant *v, gchar open, gchar close)
+{
+    gsize n = g_variant_n_children(v);
+
+    g_string_append_c(out, open);
+
+    for (gsize i = 0; i < n; i++) {
+        GVariant *child = g_variant_get_child_value(v, i);
+
+        if (i)
+            g_string_append_c(out, ',');
+
+        if (open == '{') {
+            GVariant *key = g_variant_get_child_value(child, 0);
+            GVariant *val = g_variant_get_child_value(child, 1);
+
+            if (g_variant_is_of_type(key, G_VARIANT_TYPE_STRING)
+                    || g_variant_is_of_type(key, G_VARIANT_TYPE_OBJECT_PATH)) {
+                append_string(out, g_variant_get_string(key, NULL));
+            } else {
+                gchar *str = g_variant_print(key, FALSE);
+                append_string(out, str);
+                g_free(str);
+            }
+
+            g_string_append_c(out, ':');
+            json_append(out, val);
+
+            g_variant_unref(key);
+            g_variant_unref(val);
+        } else {
+            json_append(out, child);
+        }
+
+        g_variant_unref(child);
+    }
+
+    g_string_append_c(out, close);
+}
+
+/* Append v as JSON. Tuples and arrays become arrays, dictionaries objects,
+ * empty maybes and non-finite doubles null. */
+void
+json_append(GString *out, GVariant *v)
+{
+    gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+    GVariant *inner;
+    gdouble d;
+
+    switch (g_variant_classify(v)) {
+    case G_VARIANT_CLASS_BOOLEAN:
+        g_string_append(out, g_variant_get_boolean(v) ? "true" : "false");
+        break;
+    case G_VARIANT_CLASS_BYTE:
+        g_string_append_printf(out, "%u", g_variant_get_byte(v));
+        break;
+    case G_VARIANT_CLASS_INT16:
+        g_string_append_printf(out, "%d", g_variant_get_int16(v));
+        break;
+    case G_VARIANT_CLASS_UINT16:
+        g_string_append_printf(out, "%u", g_variant_get_uint16(v));
+        break;
+    case G_VARIANT_CLASS_INT32:
+        g_string_append_printf(out, "%" G_GINT32_FORMAT,
+                g_variant_get_int32(v));
+        break;
+    case G_VARIANT_CLASS_UINT32:
+        g_string_append_printf(out, "%" G_GUINT32_FORMAT,
+                g_variant_get_uint32(v));
+        break;
+    case G_VARIANT_CLASS_INT64:
+        g_string_append_printf(out, "%" G_GINT64_FORMAT,
+                g_variant_get_int64(v));
+        break;
+    case G_VARIANT_CLASS_UINT64:
+        g_string_append_printf(out, "%" G_GUINT64_FORMAT,
+                g_variant_get_uint64(v));
+        break;
+    case G_VARIANT_CLASS_HANDLE:
+        g_string_append_printf(out, "%" G_GINT32_FORMAT,
+                g_variant_get_handle(v));
+        break;
+    case G_VARIANT_CLASS_DOUBLE:
+        d = g_variant_get_double(v);
+        if (isfinite(d))
+            g_string_append(out, g_ascii_dtostr(buf, sizeof(buf), d));
+        else
+            g_string_append(out, "null");
+        break;
+    case G_VARIANT_CLASS_STRING:
+    case G_VARIANT_CLASS_OBJECT_PATH:
+    case G_VARIANT_CLASS_SIGNATURE:
+        append_string(out, g_variant_get_string(v, NULL));
+        break;
+    case G_VARIANT_CLASS_VARIANT:
+        inner = g_variant_get_variant(v);
+        json_append(out, inner);
+        g_variant_unref(inner);
+        break;
+    case G_VARIANT_CLASS_MAYBE:
+        if (!g_variant_n_children(v)) {
+            g_string_append(out, "null");
+            break;
+        }
+        inner = g_variant_get_child_value(v, 0);
+        json_append(out, inner);
+        g_variant_unref(inner);
+        break;
+    case G_VARIANT_CLASS_ARRAY:
+        if (g_variant_type_is_dict_entry(
+                    g_variant_type_element(g_variant_get_type(v))))
+            append_children(out, v, '{', '}');
+        else
+            append_children(out, v, '[', ']');
+        break;
+    case G_VARIANT_CLASS_TUPLE:
+    case G_VARIANT_CLASS_DICT_ENTRY:
+        append_children(out, v, '[', ']');
+        break;
+    }
+}
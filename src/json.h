@@ -0,0 +1,36 @@
+/*
+sessiond - standalone X session manager
+Copyright (C) 2018-2020 James Reed
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <glib-2.0/glib.h>
+
+#define JSON_ERROR json_error_quark()
+
+typedef enum {
+    JSON_ERROR_PARSE,
+    JSON_ERROR_TYPE,
+} JsonError;
+
+extern GQuark
+json_error_quark(void);
+extern GVariant *
+json_parse(const gchar *str, GError **err);
+extern GVariant *
+json_convert(GVariant *v, const GVariantType *type, GError **err);
+extern void
+json_append(GString *out, GVariant *v);
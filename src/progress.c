@@ -0,0 +1,184 @@
+/*
+sessiond - standalone X session manager
+Copyright (C) 2018-2020 James Reed
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#define G_LOG_DOMAIN "sessiond"
+
+#include "progress.h"
+
+#include <glib-2.0/glib.h>
+
+static void
+remove_source(Progress *p)
+{
+    if (!p->source)
+        return;
+    g_source_destroy(p->source);
+    g_source_unref(p->source);
+    p->source = NULL;
+}
+
+static gboolean
+on_progress(gpointer user_data);
+
+/* Wait for the next multiple of any interval. */
+static void
+schedule(Progress *p)
+{
+    GHashTableIter iter;
+    gpointer key;
+    guint next = 0;
+
+    remove_source(p);
+
+    g_hash_table_iter_init(&iter, p->intervals);
+    while (g_hash_table_iter_next(&iter, &key, NULL)) {
+        guint sec = GPOINTER_TO_UINT(key);
+        guint n = (p->elapsed / sec + 1) * sec;
+        if (!next || n < next)
+            next = n;
+    }
+
+    if (!next)
+        return;
+
+    p->next = next;
+    p->source = g_timeout_source_new_seconds(next - p->elapsed);
+    g_source_set_callback(p->source, on_progress, p, NULL);
+    g_source_attach(p->source, p->ctx);
+}
+
+static gboolean
+on_progress(gpointer user_data)
+{
+    Progress *p = (Progress *)user_data;
+
+    g_source_unref(p->source);
+    p->source = NULL;
+
+    p->elapsed = p->next;
+    schedule(p);
+    p->func(p->elapsed, p->user_data);
+
+    return G_SOURCE_REMOVE;
+}
+
+Progress *
+progress_new(GMainContext *ctx, ProgressFunc func, gpointer user_data)
+{
+    Progress *p = g_malloc(sizeof(Progress));
+
+    p->ctx = ctx;
+    p->intervals = g_hash_table_new(NULL, NULL);
+    p->elapsed = 0;
+    p->next = 0;
+    p->source = NULL;
+    p->func = func;
+    p->user_data = user_data;
+
+    return p;
+}
+
+void
+progress_free(Progress *p)
+{
+    if (!p)
+        return;
+    remove_source(p);
+    g_hash_table_unref(p->intervals);
+    g_free(p);
+}
+
+void
+progress_add_interval(Progress *p, guint sec)
+{
+    g_return_if_fail(sec > 0);
+
+    gpointer key = GUINT_TO_POINTER(sec);
+    guint n = GPOINTER_TO_UINT(g_hash_table_lookup(p->intervals, key));
+
+    g_hash_table_insert(p->intervals, key, GUINT_TO_POINTER(n + 1));
+
+    if (progress_running(p))
+        schedule(p);
+}
+
+void
+progress_remove_interval(Progress *p, guint sec)
+{
+    gpointer key = GUINT_TO_POINTER(sec);
+    guint n = GPOINTER_TO_UINT(g_hash_table_lookup(p->intervals, key));
+
+    g_return_if_fail(n > 0);
+
+    if (n > 1) {
+        g_hash_table_insert(p->intervals, key, GUINT_TO_POINTER(n - 1));
+        return;
+    }
+
+    g_hash_table_remove(p->intervals, key);
+
+    if (!g_hash_table_size(p->intervals))
+        progress_stop(p);
+    else if (progress_running(p))
+        schedule(p);
+}
+
+/* Returns the shortest interval, or 0 if there are none. */
+guint
+progress_min_interval(Progress *p)
+{
+    GHashTableIter iter;
+    gpointer key;
+    guint min = 0;
+
+    g_hash_table_iter_init(&iter, p->intervals);
+    while (g_hash_table_iter_next(&iter, &key, NULL))
+        if (!min || GPOINTER_TO_UINT(key) < min)
+            min = GPOINTER_TO_UINT(key);
+
+    return min;
+}
+
+/* Start counting once the shortest interval has elapsed. Does nothing if
+ * progress is already running. */
+void
+progress_start(Progress *p)
+{
+    guint min = progress_min_interval(p);
+
+    if (!min || progress_running(p))
+        return;
+
+    p->elapsed = min;
+    schedule(p);
+    p->func(p->elapsed, p->user_data);
+}
+
+/* Stop counting; the next start begins again from the shortest interval. */
+void
+progress_stop(Progress *p)
+{
+    remove_source(p);
+    p->elapsed = 0;
+    p->next = 0;
+}
+
+gboolean
+progress_running(Progress *p)
+{
+    return p->elapsed > 0;
+}
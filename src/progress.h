@@ -0,0 +1,53 @@
+/*
+sessiond - standalone X session manager
+Copyright (C) 2018-2020 James Reed
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <glib-2.0/glib.h>
+
+typedef void (*ProgressFunc)(guint elapsed, gpointer user_data);
+
+/* Inactive progress starts at the shortest interval, once its timeout has
+ * elapsed, and then wakes only when a multiple of some interval is due,
+ * calling func with the seconds elapsed. Intervals are counted, so several
+ * clients may share one. */
+typedef struct {
+    GMainContext *ctx;
+    GHashTable *intervals;
+    guint elapsed;
+    guint next;
+    GSource *source;
+    ProgressFunc func;
+    gpointer user_data;
+} Progress;
+
+extern Progress *
+progress_new(GMainContext *ctx, ProgressFunc func, gpointer user_data);
+extern void
+progress_free(Progress *p);
+extern void
+progress_add_interval(Progress *p, guint sec);
+extern void
+progress_remove_interval(Progress *p, guint sec);
+extern guint
+progress_min_interval(Progress *p);
+extern void
+progress_start(Progress *p);
+extern void
+progress_stop(Progress *p);
+extern gboolean
+progress_running(Progress *p);
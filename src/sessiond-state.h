@@ -0,0 +1,211 @@
+/*
+sessiond - standalone X session manager
+Copyright (C) 2018-2020 James Reed
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* Layout of the state file that sessiond publishes at
+ * $XDG_RUNTIME_DIR/sessiond/state, with inline functions to read it. Like
+ * GLib, sessiond falls back to $XDG_CACHE_HOME, then ~/.cache, if
+ * XDG_RUNTIME_DIR is unset or empty.
+ *
+ * The file is written under a sequence lock: seq is odd while the state is
+ * being updated and is incremented again when the update is complete.
+ * Readers copy the state and retry if seq changed in the meantime. seq is
+ * also a futex word woken on every update, so readers may wait for changes
+ * with sessiond_state_wait.
+ *
+ * last_activity is updated on every input event outside of the sequence
+ * lock and does not wake waiters. */
+
+#pragma once
+
+/* open(O_CLOEXEC), PATH_MAX, struct timespec and syscall() are hidden by
+ * strict -std= modes. This only takes effect if the header is included before
+ * any system header; otherwise the includer must enable them. */
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pwd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#define SESSIOND_STATE_FILE "sessiond/state"
+#define SESSIOND_STATE_MAGIC 0x73736e64
+#define SESSIOND_STATE_VERSION 1
+
+#define SESSIOND_STATE_MAX_BACKLIGHTS 8
+#define SESSIOND_STATE_MAX_AUDIOSINKS 8
+#define SESSIOND_STATE_NAME_LEN 64
+
+/* Flags */
+#define SESSIOND_STATE_RUNNING (1 << 0)
+#define SESSIOND_STATE_IDLE (1 << 1)
+#define SESSIOND_STATE_LOCKED (1 << 2)
+#define SESSIOND_STATE_INHIBITED (1 << 3)
+
+struct sessiond_state_backlight {
+    char name[SESSIOND_STATE_NAME_LEN];
+    uint32_t brightness;
+    uint32_t max_brightness;
+};
+
+struct sessiond_state_audiosink {
+    char name[SESSIOND_STATE_NAME_LEN];
+    uint32_t id;
+    uint32_t mute;
+    double volume;
+};
+
+struct sessiond_state {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t seq;
+    uint32_t flags;
+    /* Microseconds of CLOCK_REALTIME, as the IdleSinceHint property. */
+    uint64_t idle_since_hint;
+    /* Microseconds of CLOCK_MONOTONIC. */
+    uint64_t last_activity;
+    uint32_t n_backlights;
+    uint32_t n_audiosinks;
+    /* Index into audiosinks, or -1 if there is no default sink. */
+    int32_t default_audiosink;
+    uint32_t reserved;
+    struct sessiond_state_backlight backlights[SESSIOND_STATE_MAX_BACKLIGHTS];
+    struct sessiond_state_audiosink audiosinks[SESSIOND_STATE_MAX_AUDIOSINKS];
+};
+
+/* Write the path of the state file to path, resolving the directory as
+ * g_get_user_runtime_dir does. Returns -1 and sets errno on failure. */
+static inline int
+sessiond_state_path(char *path, size_t size)
+{
+    const char *dir = getenv("XDG_RUNTIME_DIR");
+    const char *sub = "";
+    int n;
+
+    if (!dir || !*dir) {
+        dir = getenv("XDG_CACHE_HOME");
+        if (!dir || !*dir) {
+            dir = getenv("HOME");
+            if (!dir || !*dir) {
+                struct passwd *pw = getpwuid(getuid());
+                if (!pw || !pw->pw_dir) {
+                    errno = ENOENT;
+                    return -1;
+                }
+                dir = pw->pw_dir;
+            }
+            sub = "/.cache";
+        }
+    }
+
+    n = snprintf(path, size, "%s%s/%s", dir, sub, SESSIOND_STATE_FILE);
+    if (n < 0 || (size_t)n >= size) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Map the state file read-only. Returns NULL and sets errno on failure. */
+static inline const struct sessiond_state *
+sessiond_state_open(void)
+{
+    char path[PATH_MAX];
+
+    if (sessiond_state_path(path, sizeof(path)) == -1)
+        return NULL;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return NULL;
+
+    void *p = mmap(NULL, sizeof(struct sessiond_state), PROT_READ,
+            MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (p == MAP_FAILED)
+        return NULL;
+
+    const struct sessiond_state *s = p;
+    if (s->magic != SESSIOND_STATE_MAGIC
+            || s->version != SESSIOND_STATE_VERSION) {
+        munmap(p, sizeof(struct sessiond_state));
+        errno = EPROTO;
+        return NULL;
+    }
+
+    return s;
+}
+
+static inline void
+sessiond_state_close(const struct sessiond_state *s)
+{
+    munmap((void *)s, sizeof(struct sessiond_state));
+}
+
+/* Copy a consistent snapshot of the state into out. Returns its sequence
+ * number. */
+static inline uint32_t
+sessiond_state_read(const struct sessiond_state *s, struct sessiond_state *out)
+{
+    uint32_t seq;
+
+    for (;;) {
+        seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1)
+            continue;
+        memcpy(out, s, sizeof(struct sessiond_state));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&s->seq, __ATOMIC_RELAXED) == seq)
+            break;
+    }
+
+    out->seq = seq;
+    out->last_activity = __atomic_load_n(&s->last_activity, __ATOMIC_RELAXED);
+
+    return seq;
+}
+
+/* Wait until the state changes from sequence number seq. If timeout is not
+ * NULL, wait at most once for that long; the caller should compare seq again
+ * as the wait may end early. Returns -1 with errno set to ETIMEDOUT on
+ * timeout, otherwise 0. */
+static inline int
+sessiond_state_wait(const struct sessiond_state *s, uint32_t seq,
+        const struct timespec *timeout)
+{
+    while (__atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) == seq) {
+        if (syscall(SYS_futex, &s->seq, FUTEX_WAIT, seq, timeout, NULL, 0)
+                == -1 && errno != EAGAIN && errno != EINTR)
+            return -1;
+        if (timeout)
+            break;
+    }
+
+    return 0;
+}
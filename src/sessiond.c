@@ -23,8 +23,10 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 #include "dbus-logind.h"
 #include "dbus-server.h"
 #include "dbus-backlight.h"
+#include "dbus-backlight-group.h"
 #include "dbus-systemd.h"
 #include "hooks.h"
+#include "state-file.h"
 #include "timeline.h"
 #include "xsource.h"
 #include "version.h"
@@ -58,7 +60,12 @@ static gboolean inactive = FALSE;
 static gboolean idle = FALSE;
 static GMainLoop *main_loop = NULL;
 static GMainContext *main_ctx = NULL;
+static GMainLoop *input_loop = NULL;
+static GMainContext *input_ctx = NULL;
+static GThread *input_thread = NULL;
+static gboolean use_input_thread = FALSE;
 static Backlights *backlights = NULL;
+static StateFile *state_file = NULL;
 static gchar *config_path = NULL;
 static gchar *hooksd_path = NULL;
 static guint idle_sec = 0;
@@ -172,8 +179,70 @@ mute_audio_locked(gboolean state)
         default_mute = TRUE;
     }
 }
+
+static gchar *audio_inhibitor = NULL;
+
+static void
+audio_stream_cb(gboolean running)
+{
+    if (!server)
+        return;
+
+    if (running && !audio_inhibitor) {
+        audio_inhibitor = dbus_server_inhibit(server, "sessiond",
+                "Audio is playing");
+    } else if (!running && audio_inhibitor) {
+        dbus_server_uninhibit(server, audio_inhibitor);
+        g_clear_pointer(&audio_inhibitor, g_free);
+    }
+}
+
+static void
+set_inhibit_on_audio(void)
+{
+    if (!server || !server->wp_conn)
+        return;
+
+    if (config.inhibit_on_audio) {
+        wireplumber_watch_streams(server->wp_conn, audio_stream_cb);
+    } else {
+        wireplumber_unwatch_streams(server->wp_conn);
+        audio_stream_cb(FALSE);
+    }
+}
 #endif /* WIREPLUMBER */
 
+static gchar *fullscreen_inhibitor = NULL;
+
+/* The inhibitor follows the current X source, so a change reported by a
+ * source replaced since is harmless. */
+static gboolean
+sync_fullscreen_inhibitor(UNUSED gpointer user_data)
+{
+    gboolean fullscreen = config.inhibit_on_fullscreen && xsource
+        && g_atomic_int_get(&xsource->fullscreen);
+
+    if (!server)
+        return G_SOURCE_REMOVE;
+
+    if (fullscreen && !fullscreen_inhibitor) {
+        fullscreen_inhibitor = dbus_server_inhibit(server, "sessiond",
+                "A fullscreen window is active");
+    } else if (!fullscreen && fullscreen_inhibitor) {
+        dbus_server_uninhibit(server, fullscreen_inhibitor);
+        g_clear_pointer(&fullscreen_inhibitor, g_free);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+/* Runs on the input context. */
+static void
+fullscreen_cb(UNUSED gboolean fullscreen)
+{
+    g_main_context_invoke(main_ctx, sync_fullscreen_inhibitor, NULL);
+}
+
 static void
 set_idle(gboolean state)
 {
@@ -189,6 +258,7 @@ set_idle(gboolean state)
         if (config.on_idle && !logind_get_locked_hint(logind_ctx))
             logind_lock_session(logind_ctx, TRUE);
     } else {
+        dbus_server_stop_progress(server);
         timeline_start(&timeline);
         systemd_start_unit(systemd_ctx, "graphical-unidle.target");
     }
@@ -263,9 +333,10 @@ inhibit_callback(DBusServer *s, const gchar *who, const gchar *why,
 {
     g_debug("Inhibitor added: who='%s' why='%s'", who, why);
 
-    inhibited = TRUE;
+    g_atomic_int_set(&inhibited, TRUE);
     dbus_session_set_inhibited_hint(s->session, TRUE);
     inactive = FALSE;
+    dbus_server_stop_progress(s);
     timeline_stop(&timeline);
 
 #ifdef DPMS
@@ -281,8 +352,9 @@ uninhibit_callback(DBusServer *s, const gchar *who, const gchar *why,
 
     if (n > 0)
         return;
-    inhibited = FALSE;
+    g_atomic_int_set(&inhibited, FALSE);
     dbus_session_set_inhibited_hint(s->session, FALSE);
+    dbus_server_stop_progress(s);
     timeline_start(&timeline);
 
 #ifdef DPMS
@@ -290,25 +362,34 @@ uninhibit_callback(DBusServer *s, const gchar *who, const gchar *why,
 #endif /* DPMS */
 }
 
+static void
+add_timeout_callback(UNUSED DBusServer *s, guint timeout,
+        UNUSED gpointer data)
+{
+    g_debug("Client timeout added: %us", timeout);
+    timeline_ref_timeout(&timeline, timeout);
+}
+
+static void
+remove_timeout_callback(UNUSED DBusServer *s, guint timeout,
+        UNUSED gpointer data)
+{
+    g_debug("Client timeout removed: %us", timeout);
+    timeline_unref_timeout(&timeline, timeout);
+}
+
 static gboolean
 backlights_cb(BacklightAction a, const char *path, struct Backlight *bl)
 {
-    struct BacklightConf *c = NULL;
-
     switch (a) {
         case BL_ACTION_ADD:
+            backlight_configure(bl, &config);
             dbus_server_add_backlight(server, bl);
-            if (config.backlights)
-                c = g_hash_table_lookup(config.backlights, path);
-            if (c && c->dim_sec)
-                timeline_add_timeout(&timeline, c->dim_sec);
+            backlights_bind_dims(&config, path, bl, &timeline);
             break;
         case BL_ACTION_REMOVE:
             dbus_server_remove_backlight(server, path);
-            if (config.backlights)
-                c = g_hash_table_lookup(config.backlights, path);
-            if (c && c->dim_sec)
-                timeline_remove_timeout(&timeline, c->dim_sec);
+            backlights_bind_dims(&config, path, NULL, &timeline);
             break;
         case BL_ACTION_CHANGE:
         case BL_ACTION_ONLINE:
@@ -326,20 +407,32 @@ appear_callback(UNUSED LogindContext *c, UNUSED gpointer data)
     if (!server) {
         g_debug("* Init DBus server...");
         server = dbus_server_new(logind_ctx);
+        server->state_file = state_file;
+        server->broadcast_inactive = config.broadcast_inactive;
+        dbus_server_set_properties_interval(server,
+                config.properties_interval_msec);
         g_signal_connect(server, "inhibit", G_CALLBACK(inhibit_callback),
                 NULL);
         g_signal_connect(server, "uninhibit", G_CALLBACK(uninhibit_callback),
                 NULL);
+        g_signal_connect(server, "add-timeout",
+                G_CALLBACK(add_timeout_callback), NULL);
+        g_signal_connect(server, "remove-timeout",
+                G_CALLBACK(remove_timeout_callback), NULL);
 
         g_debug("* Init Backlights source...");
         backlights = backlights_new(main_ctx, backlights_cb);
 
         server->bl_devices = backlights->devices;
+        dbus_server_set_backlight_groups(server, config.backlight_groups);
 
 #ifdef WIREPLUMBER
         g_debug("* Init WirePlumber connection...");
         server->wp_conn = wireplumber_connect(main_ctx, wireplumber_cb);
+        set_inhibit_on_audio();
 #endif /* WIREPLUMBER */
+
+        sync_fullscreen_inhibitor(NULL);
     }
 
     logind_set_idle_hint(logind_ctx, FALSE);
@@ -351,18 +444,28 @@ vanish_callback(UNUSED LogindContext *c, UNUSED gpointer data)
 {
     dbus_server_free(server);
     server = NULL;
+    g_clear_pointer(&fullscreen_inhibitor, g_free);
+#ifdef WIREPLUMBER
+    g_clear_pointer(&audio_inhibitor, g_free);
+#endif /* WIREPLUMBER */
 }
 
+/* Runs on the input context. */
 static gboolean
 xsource_cb(UNUSED gpointer user_data)
 {
-    if (!xsource->connected) {
+    XSource *s = (XSource *)g_main_current_source();
+
+    if (!s->connected) {
         g_warning("X connection lost");
         g_main_loop_quit(main_loop);
         return G_SOURCE_REMOVE;
     }
 
-    if (!inhibited)
+    if (state_file)
+        state_file_set_activity(state_file, g_get_monotonic_time());
+
+    if (!g_atomic_int_get(&inhibited))
         timeline_start(&timeline);
 
     return G_SOURCE_CONTINUE;
@@ -375,25 +478,61 @@ quit_signal(UNUSED gpointer user_data)
     return TRUE;
 }
 
-static void
-on_timeout(guint timeout, gboolean state, gconstpointer user_data)
+/* Inactive may be broadcast for timeouts from the configuration; the rest
+ * were registered by clients and are signalled to them alone. */
+static gboolean
+is_config_timeout(guint timeout)
 {
+    if (timeout == config.idle_sec)
+        return TRUE;
+    if (config.backlight_dims && g_hash_table_contains(config.backlight_dims,
+                GUINT_TO_POINTER(timeout)))
+        return TRUE;
+    return config.hooks && hooks_has_timeout(config.hooks, timeout);
+}
+
+struct TimeoutCall {
+    guint timeout;
+    gboolean state;
+};
+
+static gboolean
+timeout_cb(gpointer user_data)
+{
+    struct TimeoutCall *call = (struct TimeoutCall *)user_data;
+    guint timeout = call->timeout;
+    gboolean state = call->state;
+
     if (timeout == config.idle_sec)
         set_idle(state);
 
-    if (config.backlights)
-        backlights_on_timeout(backlights->devices, config.backlights, timeout,
-                state, logind_ctx);
+    if (config.backlight_dims)
+        backlights_on_timeout(&config, timeout, state, logind_ctx);
 
     if (config.hooks)
         hooks_on_timeout(config.hooks, timeout, state);
 
     if (state)
-        dbus_server_emit_inactive(server, timeout);
+        dbus_server_emit_inactive(server, timeout,
+                is_config_timeout(timeout));
     else if (inactive)
         dbus_server_emit_active(server);
 
     inactive = state;
+
+    return G_SOURCE_REMOVE;
+}
+
+/* Runs on the input context; timeouts are handled on the main context. */
+static void
+on_timeout(guint timeout, gboolean state, UNUSED gconstpointer user_data)
+{
+    struct TimeoutCall *call = g_malloc(sizeof(struct TimeoutCall));
+    call->timeout = timeout;
+    call->state = state;
+
+    g_main_context_invoke_full(main_ctx, G_PRIORITY_DEFAULT, timeout_cb, call,
+            g_free);
 }
 
 static gboolean
@@ -430,23 +569,32 @@ err:
 }
 
 static void
-init_timeline(Timeline *tl)
+add_timeouts(Timeline *tl)
 {
-    *tl = timeline_new(main_ctx, on_timeout, NULL);
-
     timeline_add_timeout(tl, config.idle_sec);
 
     if (config.hooks)
         hooks_add_timeouts(config.hooks, tl);
 
+    if (backlights)
+        backlights_bind_all_dims(&config, backlights->devices, tl);
+
     timeline_start(tl);
 }
 
+static void
+init_timeline(Timeline *tl)
+{
+    *tl = timeline_new(input_ctx, on_timeout, NULL);
+    add_timeouts(tl);
+}
+
 static gboolean
-init_xsource(XSource **source)
+init_xsource(XSource **source, const Config *c)
 {
-    XSource *s = xsource_new(main_ctx, config.input_mask, xsource_cb, NULL,
-                             NULL);
+    XSource *s = xsource_new(input_ctx, c->input_mask,
+                             c->inhibit_on_fullscreen ? fullscreen_cb : NULL,
+                             xsource_cb, NULL, NULL);
     if (s)
         *source = s;
 
@@ -483,15 +631,31 @@ reload_signal(UNUSED gpointer user_data)
     g_message("Reloading configuration files...");
 
     XSource *s;
-    if (c.input_mask != config.input_mask && init_xsource(&s)) {
+    if ((c.input_mask != config.input_mask
+                || c.inhibit_on_fullscreen != config.inhibit_on_fullscreen)
+            && init_xsource(&s, &c)) {
         xsource_free(xsource);
         xsource = s;
     }
 
+    backlights_unbind_all_dims(&config, &timeline);
     config_free(&config);
     config = c;
-    timeline_free(&timeline);
-    init_timeline(&timeline);
+    if (server) {
+        dbus_server_set_backlight_groups(server, config.backlight_groups);
+        dbus_server_set_properties_interval(server,
+                config.properties_interval_msec);
+        server->broadcast_inactive = config.broadcast_inactive;
+#ifdef WIREPLUMBER
+        set_inhibit_on_audio();
+#endif /* WIREPLUMBER */
+        sync_fullscreen_inhibitor(NULL);
+    }
+    if (backlights)
+        backlights_configure(&config, backlights->devices);
+    dbus_server_stop_progress(server);
+    timeline_clear(&timeline);
+    add_timeouts(&timeline);
     init_dbus();
 #ifdef DPMS
     if (!no_dpms)
@@ -501,9 +665,25 @@ reload_signal(UNUSED gpointer user_data)
     return TRUE;
 }
 
+static gpointer
+run_input_loop(UNUSED gpointer data)
+{
+    g_main_context_push_thread_default(input_ctx);
+    g_main_loop_run(input_loop);
+    g_main_context_pop_thread_default(input_ctx);
+
+    return NULL;
+}
+
 static void
 cleanup(void)
 {
+    if (input_thread) {
+        g_main_loop_quit(input_loop);
+        g_thread_join(input_thread);
+        input_thread = NULL;
+        timeline.thread = NULL;
+    }
     g_free(config_path);
     g_free(hooksd_path);
     if (backlights) {
@@ -511,20 +691,27 @@ cleanup(void)
         backlights_free(backlights);
     }
     config_free(&config);
-    timeline_free(&timeline);
-    logind_context_free(logind_ctx);
-    systemd_context_free(systemd_ctx);
 
 #ifdef WIREPLUMBER
     wireplumber_disconnect(server->wp_conn);
 #endif /* WIREPLUMBER */
 
+    /* Freeing the server drops its timeouts from the timeline and its
+     * handlers from the logind context. */
     dbus_server_free(server);
+    timeline_free(&timeline);
+    logind_context_free(logind_ctx);
+    systemd_context_free(systemd_ctx);
+    state_file_free(state_file);
     xsource_free(xsource);
     if (main_ctx)
         g_main_context_unref(main_ctx);
     if (main_loop)
         g_main_loop_unref(main_loop);
+    if (input_ctx)
+        g_main_context_unref(input_ctx);
+    if (input_loop)
+        g_main_loop_unref(input_loop);
 }
 
 int
@@ -542,6 +729,8 @@ main(int argc, char *argv[])
         {"idle-sec", 'i', 0, G_OPTION_ARG_INT, &idle_sec,
             "Seconds the session must be inactive before considered idle",
             "SEC"},
+        {"input-thread", 't', 0, G_OPTION_ARG_NONE, &use_input_thread,
+            "Handle input and inactivity timeouts in a separate thread", NULL},
         {"version", 'v', 0, G_OPTION_ARG_NONE, &version, "Show version", NULL},
         {NULL},
     };
@@ -575,10 +764,24 @@ main(int argc, char *argv[])
     main_loop = g_main_loop_new(NULL, FALSE);
     main_ctx = g_main_loop_get_context(main_loop);
 
+    if (use_input_thread) {
+        XInitThreads();
+        input_ctx = g_main_context_new();
+        input_loop = g_main_loop_new(input_ctx, FALSE);
+    } else {
+        input_ctx = g_main_context_ref(main_ctx);
+    }
+
     g_debug("* Init X source...");
-    if (!init_xsource(&xsource))
+    if (!init_xsource(&xsource, &config))
         return EXIT_FAILURE;
 
+    g_debug("* Init state file...");
+    gchar *path = g_build_filename(g_get_user_runtime_dir(),
+            SESSIOND_STATE_FILE, NULL);
+    state_file = state_file_new(path);
+    g_free(path);
+
     g_debug("* Init DBus connections...");
     init_dbus();
 
@@ -593,6 +796,12 @@ main(int argc, char *argv[])
     g_unix_signal_add(SIGTERM, quit_signal, NULL);
     g_unix_signal_add(SIGHUP, reload_signal, NULL);
 
+    if (input_loop) {
+        g_debug("* Running input thread...");
+        input_thread = g_thread_new("input", run_input_loop, NULL);
+        timeline.thread = input_thread;
+    }
+
     g_debug("* Running main loop...");
     g_main_loop_run(main_loop);
 }
@@ -0,0 +1,135 @@
+/*
+sessiond - standalone X session manager
+Copyright (C) 2018-2020 James Reed
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#define G_LOG_DOMAIN "sessiond"
+
+#include "state-file.h"
+#include "sessiond-state.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <glib-2.0/glib.h>
+
+/* Map the state file at path, creating it if needed. An existing file is
+ * reused so that readers holding a mapping of it keep working after sessiond
+ * restarts. */
+StateFile *
+state_file_new(const gchar *path)
+{
+    gchar *dir = g_path_get_dirname(path);
+    gint ret = g_mkdir_with_parents(dir, 0700);
+    g_free(dir);
+
+    if (ret == -1) {
+        g_warning("Failed to create directory for %s: %s", path,
+                g_strerror(errno));
+        return NULL;
+    }
+
+    gint fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+
+    if (fd == -1) {
+        g_warning("Failed to open %s: %s", path, g_strerror(errno));
+        return NULL;
+    }
+
+    if (ftruncate(fd, sizeof(struct sessiond_state)) == -1) {
+        g_warning("Failed to resize %s: %s", path, g_strerror(errno));
+        close(fd);
+        return NULL;
+    }
+
+    void *p = mmap(NULL, sizeof(struct sessiond_state),
+            PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (p == MAP_FAILED) {
+        g_warning("Failed to map %s: %s", path, g_strerror(errno));
+        return NULL;
+    }
+
+    StateFile *f = g_malloc(sizeof(StateFile));
+    f->path = g_strdup(path);
+    f->state = p;
+
+    struct sessiond_state *s = f->state;
+    gboolean valid = s->magic == SESSIOND_STATE_MAGIC
+        && s->version == SESSIOND_STATE_VERSION;
+    guint32 seq = valid ? (s->seq + 1) & ~1u : 0;
+
+    __atomic_store_n(&s->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memset((guint8 *)s + G_STRUCT_OFFSET(struct sessiond_state, flags), 0,
+            sizeof(struct sessiond_state)
+            - G_STRUCT_OFFSET(struct sessiond_state, flags));
+    s->default_audiosink = -1;
+    s->flags = SESSIOND_STATE_RUNNING;
+    s->magic = SESSIOND_STATE_MAGIC;
+    s->version = SESSIOND_STATE_VERSION;
+    state_file_end(f);
+
+    return f;
+}
+
+/* Begin an update; readers retry until state_file_end is called. Updates
+ * must be made from a single thread. */
+void
+state_file_begin(StateFile *f)
+{
+    struct sessiond_state *s = f->state;
+
+    __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void
+state_file_end(StateFile *f)
+{
+    struct sessiond_state *s = f->state;
+
+    __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELEASE);
+    syscall(SYS_futex, &s->seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+/* May be called from any thread. */
+void
+state_file_set_activity(StateFile *f, gint64 time)
+{
+    __atomic_store_n(&f->state->last_activity, (guint64)time,
+            __ATOMIC_RELAXED);
+}
+
+void
+state_file_free(StateFile *f)
+{
+    if (!f)
+        return;
+
+    state_file_begin(f);
+    f->state->flags = 0;
+    state_file_end(f);
+
+    munmap(f->state, sizeof(struct sessiond_state));
+    g_free(f->path);
+    g_free(f);
+}
@@ -0,0 +1,38 @@
+/*
+sessiond - standalone X session manager
+Copyright (C) 2018-2020 James Reed
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "sessiond-state.h"
+
+#include <glib-2.0/glib.h>
+
+typedef struct {
+    gchar *path;
+    struct sessiond_state *state;
+} StateFile;
+
+extern StateFile *
+state_file_new(const gchar *path);
+extern void
+state_file_begin(StateFile *f);
+extern void
+state_file_end(StateFile *f);
+extern void
+state_file_set_activity(StateFile *f, gint64 time);
+extern void
+state_file_free(StateFile *f);
@@ -0,0 +1,114 @@
+/*
+sessiond - standalone X session manager
+Copyright (C) 2018-2020 James Reed
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#define G_LOG_DOMAIN "sessiond"
+
+#include "throttle.h"
+
+#include <glib-2.0/glib.h>
+
+static void
+remove_source(Throttle *t)
+{
+    if (!t->source)
+        return;
+    g_source_destroy(t->source);
+    g_source_unref(t->source);
+    t->source = NULL;
+}
+
+static void
+run(Throttle *t)
+{
+    remove_source(t);
+    t->last = g_get_monotonic_time();
+    t->func(t->user_data);
+}
+
+static gboolean
+on_timeout(gpointer user_data)
+{
+    run((Throttle *)user_data);
+    return G_SOURCE_REMOVE;
+}
+
+Throttle *
+throttle_new(guint interval, ThrottleFunc func, gpointer user_data,
+        GDestroyNotify notify)
+{
+    Throttle *t = g_malloc(sizeof(Throttle));
+
+    t->interval = interval;
+    t->last = -1;
+    t->source = NULL;
+    t->func = func;
+    t->user_data = user_data;
+    t->notify = notify;
+
+    return t;
+}
+
+void
+throttle_set_interval(Throttle *t, guint interval)
+{
+    t->interval = interval;
+    if (t->source)
+        run(t);
+}
+
+void
+throttle_queue(Throttle *t)
+{
+    if (t->source)
+        return;
+
+    gint64 elapsed = (g_get_monotonic_time() - t->last) / 1000;
+
+    if (t->last == -1 || elapsed >= t->interval) {
+        run(t);
+        return;
+    }
+
+    t->source = g_timeout_source_new(t->interval - elapsed);
+    g_source_set_callback(t->source, on_timeout, t, NULL);
+    g_source_attach(t->source, NULL);
+}
+
+/* Run func now if a request is pending. */
+void
+throttle_flush(Throttle *t)
+{
+    if (t->source)
+        run(t);
+}
+
+gboolean
+throttle_pending(Throttle *t)
+{
+    return t->source != NULL;
+}
+
+void
+throttle_free(Throttle *t)
+{
+    if (!t)
+        return;
+    remove_source(t);
+    if (t->notify)
+        t->notify(t->user_data);
+    g_free(t);
+}
@@ -0,0 +1,48 @@
+/*
+sessiond - standalone X session manager
+Copyright (C) 2018-2020 James Reed
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <glib-2.0/glib.h>
+
+typedef void (*ThrottleFunc)(gpointer user_data);
+
+/* Coalesces requests to run func so that it runs at most once per interval
+ * (in milliseconds). A request after a quiet interval runs func at once;
+ * requests within the interval run it once when the interval ends. */
+typedef struct {
+    guint interval;
+    gint64 last;
+    GSource *source;
+    ThrottleFunc func;
+    gpointer user_data;
+    GDestroyNotify notify;
+} Throttle;
+
+extern Throttle *
+throttle_new(guint interval, ThrottleFunc func, gpointer user_data,
+        GDestroyNotify notify);
+extern void
+throttle_set_interval(Throttle *t, guint interval);
+extern void
+throttle_queue(Throttle *t);
+extern void
+throttle_flush(Throttle *t);
+extern gboolean
+throttle_pending(Throttle *t);
+extern void
+throttle_free(Throttle *t);
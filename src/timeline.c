@@ -26,25 +26,147 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 
 static void
 add_timeout(Timeline *tl, guint timeout);
+static void
+remove_source(Timeline *tl);
+
+/* A timeout is kept while it is added or while it has references. */
+typedef struct {
+    guint timeout;
+    gboolean added;
+    guint refs;
+} TimelineTimeout;
+
+typedef struct {
+    Timeline *tl;
+    guint timeout;
+} TimelineCall;
+
+typedef struct {
+    Timeline *tl;
+    guint timeout;
+    gboolean result;
+    gboolean done;
+    GMutex mutex;
+    GCond cond;
+} TimelineSyncCall;
+
+/* If the timeline is bound to a thread, calls made from any other thread are
+ * queued in order to the timeline's context and return TRUE. */
+static gboolean
+timeline_invoke(Timeline *tl, GSourceFunc func, guint timeout)
+{
+    if (!tl->thread || tl->thread == g_thread_self())
+        return FALSE;
+
+    TimelineCall *call = g_malloc(sizeof(TimelineCall));
+    call->tl = tl;
+    call->timeout = timeout;
+
+    g_main_context_invoke_full(tl->ctx, G_PRIORITY_DEFAULT, func, call,
+            g_free);
+
+    return TRUE;
+}
 
-static gint
-compare_timeouts(gconstpointer a, gconstpointer b)
+/* As timeline_invoke, but wait for the call to run on the timeline's thread
+ * and store its return value in result. The timeline's thread never waits on
+ * other threads, so this cannot deadlock while its loop is running. */
+static gboolean
+timeline_invoke_sync(Timeline *tl, GSourceFunc func, guint timeout,
+        gboolean *result)
 {
-    guint time_a = *(guint *)a;
-    guint time_b = *(guint *)b;
+    if (!tl->thread || tl->thread == g_thread_self())
+        return FALSE;
+
+    TimelineSyncCall call = {tl, timeout, FALSE, FALSE};
+    g_mutex_init(&call.mutex);
+    g_cond_init(&call.cond);
+
+    g_main_context_invoke_full(tl->ctx, G_PRIORITY_DEFAULT, func, &call,
+            NULL);
 
-    if (time_a < time_b)
-        return -1;
-    if (time_a > time_b)
-        return 1;
+    g_mutex_lock(&call.mutex);
+    while (!call.done)
+        g_cond_wait(&call.cond, &call.mutex);
+    g_mutex_unlock(&call.mutex);
 
-    return 0;
+    g_mutex_clear(&call.mutex);
+    g_cond_clear(&call.cond);
+
+    *result = call.result;
+    return TRUE;
 }
 
+#define TIMELINE_CALL_FUNC(name, call) \
+    static gboolean \
+    name##_cb(gpointer user_data) \
+    { \
+        TimelineCall *c = (TimelineCall *)user_data; \
+        call; \
+        return G_SOURCE_REMOVE; \
+    }
+
+#define TIMELINE_SYNC_CALL_FUNC(name, call) \
+    static gboolean \
+    name##_cb(gpointer user_data) \
+    { \
+        TimelineSyncCall *c = (TimelineSyncCall *)user_data; \
+        gboolean result = call; \
+        g_mutex_lock(&c->mutex); \
+        c->result = result; \
+        c->done = TRUE; \
+        g_cond_signal(&c->cond); \
+        g_mutex_unlock(&c->mutex); \
+        return G_SOURCE_REMOVE; \
+    }
+
+TIMELINE_SYNC_CALL_FUNC(add_timeout,
+        timeline_add_timeout(c->tl, c->timeout))
+TIMELINE_SYNC_CALL_FUNC(remove_timeout,
+        timeline_remove_timeout(c->tl, c->timeout))
+TIMELINE_CALL_FUNC(ref_timeout, timeline_ref_timeout(c->tl, c->timeout))
+TIMELINE_CALL_FUNC(unref_timeout, timeline_unref_timeout(c->tl, c->timeout))
+TIMELINE_CALL_FUNC(start, timeline_start(c->tl))
+TIMELINE_CALL_FUNC(stop, timeline_stop(c->tl))
+TIMELINE_CALL_FUNC(clear, timeline_clear(c->tl))
+
+#define TIMEOUT_AT(tl, i) (&g_array_index(tl->timeouts, TimelineTimeout, i))
+
 static guint
 get_timeout(Timeline *tl)
 {
-    return g_array_index(tl->timeouts, guint, tl->index);
+    return TIMEOUT_AT(tl, tl->index)->timeout;
+}
+
+static TimelineTimeout *
+find_timeout(Timeline *tl, guint timeout, guint *index)
+{
+    for (guint i = 0; i < tl->timeouts->len; i++) {
+        TimelineTimeout *t = TIMEOUT_AT(tl, i);
+        if (t->timeout == timeout) {
+            if (index)
+                *index = i;
+            return t;
+        }
+    }
+
+    return NULL;
+}
+
+/* Arm the source for the next pending timeout. If none remain, the inactive
+ * time is kept so that a longer timeout added later is still scheduled. */
+static void
+schedule_next(Timeline *tl)
+{
+    if (tl->index >= tl->timeouts->len) {
+        remove_source(tl);
+        return;
+    }
+
+    guint inactive = INACTIVE_SEC(tl);
+    guint timeout = get_timeout(tl);
+
+    add_timeout(tl, timeout > inactive ? timeout - inactive : 0);
 }
 
 static gboolean
@@ -61,10 +183,7 @@ on_timeout(gpointer user_data)
     if (inactive >= timeout) {
         tl->index++;
         tl->func(timeout, TRUE, tl->user_data);
-        if (tl->index < tl->timeouts->len)
-            add_timeout(tl, get_timeout(tl) - inactive);
-        else
-            timeline_stop(tl);
+        schedule_next(tl);
     } else {
         add_timeout(tl, timeout - inactive);
     }
@@ -101,8 +220,9 @@ timeline_new(GMainContext *ctx, TimelineFunc func, gconstpointer user_data)
     Timeline tl;
     tl.running = FALSE;
     tl.ctx = ctx;
+    tl.thread = NULL;
     tl.source = NULL;
-    tl.timeouts = g_array_new(FALSE, FALSE, sizeof(guint));
+    tl.timeouts = g_array_new(FALSE, FALSE, sizeof(TimelineTimeout));
     tl.index = 0;
     tl.inactive_since = -1;
     tl.func = func;
@@ -110,60 +230,142 @@ timeline_new(GMainContext *ctx, TimelineFunc func, gconstpointer user_data)
     return tl;
 }
 
-gboolean
-timeline_add_timeout(Timeline *tl, guint timeout)
+/* Insert a timeout in order. If the timeline is running, a timeout shorter
+ * than the current inactive time fires immediately and the source is rearmed
+ * when the new timeout is the next one pending. */
+static TimelineTimeout *
+insert_timeout(Timeline *tl, guint timeout)
 {
-    for (guint i = 0; i < tl->timeouts->len; i++)
-        if (g_array_index(tl->timeouts, guint, i) == timeout)
-            return FALSE;
+    TimelineTimeout t = {timeout, FALSE, 0};
+    guint i = 0;
+
+    while (i < tl->timeouts->len && TIMEOUT_AT(tl, i)->timeout < timeout)
+        i++;
 
-    g_array_append_val(tl->timeouts, timeout);
+    g_array_insert_val(tl->timeouts, i, t);
     g_debug("timeline: Added %us timeout", timeout);
 
-    if (tl->running) {
-        remove_source(tl);
-        g_array_sort(tl->timeouts, compare_timeouts);
-        tl->index = 0;
-        guint inactive = INACTIVE_SEC(tl);
-        for (guint i = 0; i < tl->timeouts->len; i++) {
-            guint t = g_array_index(tl->timeouts, guint, i);
-            if (t <= inactive)
-                tl->index++;
-        }
-        if (inactive >= timeout)
+    if (!tl->running || i > tl->index)
+        return TIMEOUT_AT(tl, i);
+
+    if (i < tl->index) {
+        tl->index++;
+        tl->func(timeout, TRUE, tl->user_data);
+    } else if (tl->inactive_since != -1) {
+        if (INACTIVE_SEC(tl) >= timeout) {
+            tl->index++;
             tl->func(timeout, TRUE, tl->user_data);
-        add_timeout(tl, get_timeout(tl) - inactive);
+        }
+        schedule_next(tl);
     }
 
-    return TRUE;
+    return TIMEOUT_AT(tl, i);
 }
 
+static void
+remove_timeout_at(Timeline *tl, guint i)
+{
+    g_debug("timeline: Removed %us timeout", TIMEOUT_AT(tl, i)->timeout);
+    g_array_remove_index(tl->timeouts, i);
+
+    if (i < tl->index) {
+        tl->index--;
+    } else if (i == tl->index && tl->running && tl->inactive_since != -1) {
+        remove_source(tl);
+        schedule_next(tl);
+    }
+}
+
+/* Returns FALSE if the timeout was already added. Calls from other threads
+ * wait for the result. */
+gboolean
+timeline_add_timeout(Timeline *tl, guint timeout)
+{
+    gboolean result;
+
+    if (timeline_invoke_sync(tl, add_timeout_cb, timeout, &result))
+        return result;
+
+    TimelineTimeout *t = find_timeout(tl, timeout, NULL);
+    gboolean added = t && t->added;
+
+    if (!t)
+        t = insert_timeout(tl, timeout);
+    t->added = TRUE;
+
+    return !added;
+}
+
+/* Returns FALSE if the timeout was not added. Calls from other threads wait
+ * for the result. */
 gboolean
 timeline_remove_timeout(Timeline *tl, guint timeout)
 {
-    for (guint i = 0; i < tl->timeouts->len; i++)
-        if (g_array_index(tl->timeouts, guint, i) == timeout) {
-            g_array_remove_index(tl->timeouts, i);
-            if (i <= tl->index)
-                tl->index--;
-            return TRUE;
-        }
+    gboolean result;
+
+    if (timeline_invoke_sync(tl, remove_timeout_cb, timeout, &result))
+        return result;
+
+    guint i;
+    TimelineTimeout *t = find_timeout(tl, timeout, &i);
+
+    if (!t || !t->added)
+        return FALSE;
+
+    t->added = FALSE;
+    if (!t->refs)
+        remove_timeout_at(tl, i);
+
+    return TRUE;
+}
+
+/* Referenced timeouts are independent of timeline_add_timeout and are kept
+ * across timeline_clear until the last reference is dropped. */
+void
+timeline_ref_timeout(Timeline *tl, guint timeout)
+{
+    if (timeline_invoke(tl, ref_timeout_cb, timeout))
+        return;
+
+    TimelineTimeout *t = find_timeout(tl, timeout, NULL);
+
+    if (!t)
+        t = insert_timeout(tl, timeout);
+    t->refs++;
+}
 
-    return FALSE;
+void
+timeline_unref_timeout(Timeline *tl, guint timeout)
+{
+    if (timeline_invoke(tl, unref_timeout_cb, timeout))
+        return;
+
+    guint i;
+    TimelineTimeout *t = find_timeout(tl, timeout, &i);
+
+    g_return_if_fail(t && t->refs > 0);
+
+    if (--t->refs == 0 && !t->added)
+        remove_timeout_at(tl, i);
 }
 
 void
 timeline_start(Timeline *tl)
 {
+    if (timeline_invoke(tl, start_cb, 0))
+        return;
+
     if (tl->running) {
         while (tl->index) {
             tl->index--;
             tl->func(get_timeout(tl), FALSE, tl->user_data);
         }
-    } else if (tl->timeouts->len > 0) {
-        g_array_sort(tl->timeouts, compare_timeouts);
-        tl->running = TRUE;
-    } else {
+    }
+
+    tl->running = tl->timeouts->len > 0;
+    if (!tl->running) {
+        remove_source(tl);
+        tl->inactive_since = -1;
         return;
     }
 
@@ -175,6 +377,9 @@ timeline_start(Timeline *tl)
 void
 timeline_stop(Timeline *tl)
 {
+    if (timeline_invoke(tl, stop_cb, 0))
+        return;
+
     if (!tl->running)
         return;
     if (!tl->index)
@@ -183,9 +388,32 @@ timeline_stop(Timeline *tl)
     remove_source(tl);
 }
 
+/* Remove all added timeouts without running callbacks. Referenced timeouts
+ * are kept. */
+void
+timeline_clear(Timeline *tl)
+{
+    if (timeline_invoke(tl, clear_cb, 0))
+        return;
+
+    remove_source(tl);
+    for (guint i = tl->timeouts->len; i-- > 0;) {
+        TimelineTimeout *t = TIMEOUT_AT(tl, i);
+        t->added = FALSE;
+        if (!t->refs)
+            g_array_remove_index(tl->timeouts, i);
+    }
+    tl->running = FALSE;
+    tl->index = 0;
+    tl->inactive_since = -1;
+}
+
+/* Must be called on the timeline's thread, as the timeouts are not locked. */
 guint
 timeline_pending_timeouts(Timeline *tl)
 {
+    g_return_val_if_fail(!tl->thread || tl->thread == g_thread_self(), 0);
+
     return tl->timeouts->len - tl->index;
 }
 
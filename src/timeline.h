@@ -25,6 +25,7 @@ typedef void (*TimelineFunc)(guint timeout, gboolean state,
 typedef struct {
     gboolean running;
     GMainContext *ctx;
+    GThread *thread;
     GSource *source;
     GArray *timeouts;
     guint index;
@@ -40,9 +41,15 @@ timeline_add_timeout(Timeline *tl, guint timeout);
 extern gboolean
 timeline_remove_timeout(Timeline *tl, guint timeout);
 extern void
+timeline_ref_timeout(Timeline *tl, guint timeout);
+extern void
+timeline_unref_timeout(Timeline *tl, guint timeout);
+extern void
 timeline_start(Timeline *tl);
 extern void
 timeline_stop(Timeline *tl);
+extern void
+timeline_clear(Timeline *tl);
 extern guint
 timeline_pending_timeouts(Timeline *tl);
 extern void
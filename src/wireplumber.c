@@ -18,6 +18,7 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 #define G_LOG_DOMAIN "sessiond-wireplumber"
 
 #include "wireplumber.h"
+#include "common.h"
 
 #include <glib-2.0/glib.h>
 #include <pipewire/keys.h>
@@ -65,27 +66,38 @@ on_disconnect(WpConn *conn)
         g_object_unref(conn->nodes_api);
 }
 
-static struct AudioSink *
-new_audiosink(WpConn *conn, guint32 id, WpPipewireObject *obj)
+static void
+free_audiosink(struct AudioSink *as)
 {
-    struct AudioSink *as = g_malloc0(sizeof(struct AudioSink));
-
-    as->id = id;
-    if (obj)
-        as->name = get_object_name(obj);
-
-    if (!audiosink_get_volume_mute(conn, id, &as->volume, &as->mute))
-        return NULL;
-
-    return as;
+    g_free((gchar *)as->name);
+    g_free(as);
 }
 
+/* The mixer reports changes of any node, including streams. Only cached
+ * sinks whose volume or mute state differ are passed on. */
 static void
-on_object_changed(WpConn *conn, guint32 id)
+on_mixer_changed(WpConn *conn, guint32 id)
 {
-    struct AudioSink *as = new_audiosink(conn, id, NULL);
+    struct AudioSink *as = g_hash_table_lookup(conn->sinks,
+            GUINT_TO_POINTER(id));
+    gdouble volume;
+    gboolean mute;
+
+    if (!as)
+        return;
+
+    volume = as->volume;
+    mute = as->mute;
+
+    if (!audiosink_get_volume_mute(conn, id, &volume, &mute))
+        return;
+
+    if (volume == as->volume && mute == as->mute)
+        return;
+
+    as->volume = volume;
+    as->mute = mute;
     conn->func(AS_ACTION_CHANGE, id, as);
-    g_free(as);
 }
 
 static void
@@ -95,12 +107,13 @@ on_object_added(WpConn *conn, WpPipewireObject *obj)
 
     g_debug("Added audio sink: %d", id);
 
-    g_signal_connect_swapped(conn->mixer_api, "changed",
-            G_CALLBACK(on_object_changed), conn);
+    struct AudioSink *as = g_malloc0(sizeof(struct AudioSink));
+    as->id = id;
+    as->name = g_strdup(get_object_name(obj));
+    audiosink_get_volume_mute(conn, id, &as->volume, &as->mute);
 
-    struct AudioSink *as = new_audiosink(conn, id, obj);
+    g_hash_table_replace(conn->sinks, GUINT_TO_POINTER(id), as);
     conn->func(AS_ACTION_ADD, id, as);
-    g_free(as);
 }
 
 static void
@@ -111,6 +124,7 @@ on_object_removed(WpConn *conn, WpPipewireObject *obj)
     g_debug("Removed audio sink: %d", id);
 
     conn->func(AS_ACTION_REMOVE, id, NULL);
+    g_hash_table_remove(conn->sinks, GUINT_TO_POINTER(id));
 }
 
 static void
@@ -188,6 +202,93 @@ audiosink_get_volume_mute(WpConn *conn, guint32 id, gdouble *v, gboolean *m)
     return TRUE;
 }
 
+/* Playback streams are counted while they are running; func is called when
+ * the first one starts and when the last one stops. */
+static void
+set_stream_running(WpConn *conn, guint32 id, gboolean running)
+{
+    guint n = g_hash_table_size(conn->running_streams);
+
+    if (running)
+        g_hash_table_add(conn->running_streams, GUINT_TO_POINTER(id));
+    else
+        g_hash_table_remove(conn->running_streams, GUINT_TO_POINTER(id));
+
+    guint m = g_hash_table_size(conn->running_streams);
+
+    if (!n != !m) {
+        g_debug("Audio streams running: %s", m ? "true" : "false");
+        conn->stream_func(m > 0);
+    }
+}
+
+static void
+on_stream_state_changed(WpNode *node, UNUSED WpNodeState old,
+        WpNodeState new, WpConn *conn)
+{
+    set_stream_running(conn, wp_proxy_get_bound_id(WP_PROXY(node)),
+            new == WP_NODE_STATE_RUNNING);
+}
+
+static void
+on_stream_added(WpConn *conn, WpNode *node)
+{
+    g_signal_connect(node, "state-changed",
+            G_CALLBACK(on_stream_state_changed), conn);
+
+    set_stream_running(conn, wp_proxy_get_bound_id(WP_PROXY(node)),
+            wp_node_get_state(node, NULL) == WP_NODE_STATE_RUNNING);
+}
+
+static void
+on_stream_removed(WpConn *conn, WpNode *node)
+{
+    g_signal_handlers_disconnect_by_data(node, conn);
+    set_stream_running(conn, wp_proxy_get_bound_id(WP_PROXY(node)), FALSE);
+}
+
+void
+wireplumber_watch_streams(WpConn *conn, AudioStreamFunc func)
+{
+    if (conn->streams)
+        return;
+
+    conn->stream_func = func;
+    conn->running_streams = g_hash_table_new(NULL, NULL);
+    conn->streams = wp_object_manager_new();
+
+    wp_object_manager_add_interest(conn->streams, WP_TYPE_NODE,
+        WP_CONSTRAINT_TYPE_PW_PROPERTY, PW_KEY_MEDIA_CLASS, "=s",
+        "Stream/Output/Audio", NULL);
+    wp_object_manager_request_object_features(conn->streams, WP_TYPE_NODE,
+            WP_PIPEWIRE_OBJECT_FEATURES_MINIMAL);
+
+    g_signal_connect_swapped(conn->streams, "object-added",
+            G_CALLBACK(on_stream_added), conn);
+    g_signal_connect_swapped(conn->streams, "object-removed",
+            G_CALLBACK(on_stream_removed), conn);
+
+    wp_core_install_object_manager(conn->core, conn->streams);
+}
+
+/* Stop watching streams. func is not called. */
+void
+wireplumber_unwatch_streams(WpConn *conn)
+{
+    if (!conn->streams)
+        return;
+
+    WpIterator *iter = wp_object_manager_new_iterator(conn->streams);
+    GValue val = G_VALUE_INIT;
+
+    for (; wp_iterator_next(iter, &val); g_value_unset(&val))
+        g_signal_handlers_disconnect_by_data(g_value_get_object(&val), conn);
+    wp_iterator_unref(iter);
+
+    g_clear_object(&conn->streams);
+    g_clear_pointer(&conn->running_streams, g_hash_table_unref);
+}
+
 WpConn *
 wireplumber_connect(GMainContext *ctx, AudioSinkFunc func)
 {
@@ -196,6 +297,8 @@ wireplumber_connect(GMainContext *ctx, AudioSinkFunc func)
     WpConn *conn = g_malloc0(sizeof(WpConn));
     conn->core = wp_core_new(ctx, NULL);
     conn->manager = wp_object_manager_new();
+    conn->sinks = g_hash_table_new_full(NULL, NULL, NULL,
+            (GDestroyNotify)free_audiosink);
     conn->func = func;
 
     wp_object_manager_add_interest(conn->manager, WP_TYPE_NODE,
@@ -248,6 +351,8 @@ wireplumber_connect(GMainContext *ctx, AudioSinkFunc func)
 
     g_signal_connect_swapped(conn->nodes_api, "changed",
             G_CALLBACK(update_default_id), conn);
+    g_signal_connect_swapped(conn->mixer_api, "changed",
+            G_CALLBACK(on_mixer_changed), conn);
 
     return conn;
 
@@ -27,6 +27,7 @@ typedef enum {
     AS_ACTION_CHANGE_DEFAULT,
 } AudioSinkAction;
 
+/* Sinks are cached by WpConn, which owns their names. */
 struct AudioSink {
     guint32 id;
     const gchar *name;
@@ -37,6 +38,8 @@ struct AudioSink {
 typedef void (*AudioSinkFunc)(AudioSinkAction a, guint32 id,
         struct AudioSink *as);
 
+typedef void (*AudioStreamFunc)(gboolean running);
+
 typedef struct {
     WpCore *core;
     WpObjectManager *manager;
@@ -44,7 +47,11 @@ typedef struct {
     WpPlugin *mixer_api;
     WpPlugin *nodes_api;
     guint32 default_id;
+    GHashTable *sinks;
     AudioSinkFunc func;
+    WpObjectManager *streams;
+    GHashTable *running_streams;
+    AudioStreamFunc stream_func;
 } WpConn;
 
 extern gboolean
@@ -53,6 +60,10 @@ extern gboolean
 audiosink_set_mute(guint32 id, gboolean m, WpConn *conn);
 extern gboolean
 audiosink_get_volume_mute(WpConn *conn, guint32 id, gdouble *v, gboolean *m);
+extern void
+wireplumber_watch_streams(WpConn *conn, AudioStreamFunc func);
+extern void
+wireplumber_unwatch_streams(WpConn *conn);
 extern WpConn *
 wireplumber_connect(GMainContext *ctx, AudioSinkFunc func);
 extern void
@@ -22,6 +22,7 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 
 #include <stdlib.h>
 #include <glib-2.0/glib.h>
+#include <X11/Xatom.h>
 #include <X11/Xlib.h>
 #include <X11/extensions/XInput.h>
 #include <X11/extensions/XInput2.h>
@@ -31,6 +32,133 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 #define XI_MAJOR_VERSION 2
 #define XI_MINOR_VERSION 0
 
+/* Windows may be destroyed before their properties are read. The handler is
+ * installed only around those requests. */
+static int
+on_x_error(Display *dpy, XErrorEvent *ev)
+{
+    if (ev->error_code == BadWindow) {
+        g_debug("Ignoring BadWindow error for window %lu", ev->resourceid);
+        return 0;
+    }
+
+    char msg[128];
+    XGetErrorText(dpy, ev->error_code, msg, sizeof(msg));
+    g_warning("X error: %s", msg);
+
+    return 0;
+}
+
+static XErrorHandler
+trap_errors(void)
+{
+    return XSetErrorHandler(on_x_error);
+}
+
+/* Errors are reported when requests are processed, so sync before restoring
+ * the previous handler. */
+static void
+untrap_errors(XSource *self, XErrorHandler handler)
+{
+    XSync(self->dpy, False);
+    XSetErrorHandler(handler);
+}
+
+/* Returns the property's items, to be freed with XFree, or NULL with n set
+ * to 0. */
+static guchar *
+get_property(XSource *self, Window w, Atom property, Atom type, gulong *n)
+{
+    Atom actual_type;
+    int format;
+    gulong after;
+    guchar *data = NULL;
+
+    *n = 0;
+
+    if (XGetWindowProperty(self->dpy, w, property, 0, G_MAXLONG / 4, False,
+                type, &actual_type, &format, n, &after, &data) != Success) {
+        *n = 0;
+        return NULL;
+    }
+
+    if (actual_type != type || format != 32 || !*n) {
+        if (data)
+            XFree(data);
+        *n = 0;
+        return NULL;
+    }
+
+    return data;
+}
+
+static void
+update_fullscreen(XSource *self)
+{
+    gboolean fullscreen = FALSE;
+    gulong n = 0;
+    Atom *states = NULL;
+
+    if (self->active_window != None)
+        states = (Atom *)get_property(self, self->active_window,
+                self->net_wm_state, XA_ATOM, &n);
+
+    for (gulong i = 0; states && i < n; i++)
+        if (states[i] == self->net_wm_state_fullscreen)
+            fullscreen = TRUE;
+
+    if (states)
+        XFree(states);
+
+    if (fullscreen == self->fullscreen)
+        return;
+
+    g_debug("Fullscreen: %s", BOOLSTR(fullscreen));
+    g_atomic_int_set(&self->fullscreen, fullscreen);
+    self->fullscreen_changed = TRUE;
+}
+
+/* Property events are selected on the active window only. */
+static void
+update_active_window(XSource *self)
+{
+    gulong n = 0;
+    Window *w = (Window *)get_property(self, DefaultRootWindow(self->dpy),
+            self->net_active_window, XA_WINDOW, &n);
+    Window active = w ? *w : None;
+
+    if (w)
+        XFree(w);
+
+    if (active != self->active_window) {
+        if (self->active_window != None)
+            XSelectInput(self->dpy, self->active_window, NoEventMask);
+        if (active != None)
+            XSelectInput(self->dpy, active, PropertyChangeMask);
+        self->active_window = active;
+    }
+
+    update_fullscreen(self);
+}
+
+static void
+handle_property(XSource *self, XPropertyEvent *ev)
+{
+    XErrorHandler handler;
+
+    if (ev->window == DefaultRootWindow(self->dpy)
+            && ev->atom == self->net_active_window) {
+        handler = trap_errors();
+        update_active_window(self);
+        untrap_errors(self, handler);
+    } else if (ev->window == self->active_window
+            && ev->atom == self->net_wm_state) {
+        handler = trap_errors();
+        update_fullscreen(self);
+        untrap_errors(self, handler);
+    }
+}
+
 static gboolean
 xsource_prepare(GSource *source, gint *timeout)
 {
@@ -38,7 +166,7 @@ xsource_prepare(GSource *source, gint *timeout)
     XSync(self->dpy, FALSE);
     *timeout = -1;
 
-    return FALSE;
+    return self->fullscreen_changed;
 }
 
 static gboolean
@@ -52,8 +180,10 @@ xsource_check(GSource *source)
         return TRUE;
     }
 
-    if (!(revents & G_IO_IN))
-        return FALSE;
+    /* Property reads may queue events without the connection being
+     * readable. */
+    if (!(revents & G_IO_IN) && !XQLength(self->dpy))
+        return self->fullscreen_changed;
 
     guint events = 0;
 
@@ -61,6 +191,11 @@ xsource_check(GSource *source)
         XEvent ev;
         XNextEvent(self->dpy, &ev);
 
+        if (ev.type == PropertyNotify && self->fullscreen_func) {
+            handle_property(self, &ev.xproperty);
+            continue;
+        }
+
         if (ev.type != GenericEvent)
             continue;
 
@@ -86,7 +221,7 @@ xsource_check(GSource *source)
         g_source_set_ready_time(source, self->last_event_time + DEBOUNCE_US);
     }
 
-    return FALSE;
+    return self->fullscreen_changed;
 }
 
 static gboolean
@@ -94,6 +229,15 @@ xsource_dispatch(GSource *source, GSourceFunc func, gpointer user_data)
 {
     XSource *self = (XSource *)source;
 
+    if (self->fullscreen_changed) {
+        self->fullscreen_changed = FALSE;
+        self->fullscreen_func(self->fullscreen);
+    }
+
+    /* Dispatched for a fullscreen change alone. */
+    if (self->connected && g_source_get_ready_time(source) == -1)
+        return G_SOURCE_CONTINUE;
+
     if (g_get_monotonic_time() - self->last_event_time >= DEBOUNCE_US) {
         g_source_set_ready_time(source, -1);
         return func(user_data);
@@ -121,7 +265,8 @@ static GSourceFuncs xsource_funcs = {
 };
 
 XSource *
-xsource_new(GMainContext *ctx, guint input_mask, GSourceFunc func,
+xsource_new(GMainContext *ctx, guint input_mask,
+            XSourceFullscreenFunc fullscreen_func, GSourceFunc func,
             gpointer user_data, GDestroyNotify destroy)
 {
     Display *dpy = XOpenDisplay(NULL);
@@ -166,6 +311,23 @@ xsource_new(GMainContext *ctx, guint input_mask, GSourceFunc func,
 
     self->last_event_time = 0;
 
+    self->fullscreen_func = fullscreen_func;
+    self->active_window = None;
+    self->fullscreen = FALSE;
+    self->fullscreen_changed = FALSE;
+
+    if (fullscreen_func) {
+        self->net_active_window = XInternAtom(dpy, "_NET_ACTIVE_WINDOW", False);
+        self->net_wm_state = XInternAtom(dpy, "_NET_WM_STATE", False);
+        self->net_wm_state_fullscreen = XInternAtom(dpy,
+                "_NET_WM_STATE_FULLSCREEN", False);
+        XSelectInput(dpy, DefaultRootWindow(dpy), PropertyChangeMask);
+
+        XErrorHandler handler = trap_errors();
+        update_active_window(self);
+        untrap_errors(self, handler);
+    }
+
     g_source_set_callback(source, func, user_data, destroy);
     g_source_attach(source, ctx);
 
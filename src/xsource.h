@@ -36,16 +36,29 @@ enum {
     INPUT_TYPE_COUNT
 };
 
+typedef void (*XSourceFullscreenFunc)(gboolean fullscreen);
+
+/* If fullscreen_func is set, the active window is tracked through property
+ * events and fullscreen_func is called from the source's context when its
+ * fullscreen state changes, including once on creation if it is fullscreen. */
 typedef struct {
     GSource source;
     Display *dpy;
     gpointer fd;
     gboolean connected;
     gint64 last_event_time;
+    XSourceFullscreenFunc fullscreen_func;
+    Atom net_active_window;
+    Atom net_wm_state;
+    Atom net_wm_state_fullscreen;
+    Window active_window;
+    gboolean fullscreen;
+    gboolean fullscreen_changed;
 } XSource;
 
 extern XSource *
-xsource_new(GMainContext *ctx, guint input_mask, GSourceFunc func,
+xsource_new(GMainContext *ctx, guint input_mask,
+            XSourceFullscreenFunc fullscreen_func, GSourceFunc func,
             gpointer user_data, GDestroyNotify destroy);
 extern void
 xsource_free(XSource *self);
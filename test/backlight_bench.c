@@ -0,0 +1,55 @@
+#include "../src/backlight.h"
+
+#include <locale.h>
+#include <glib-2.0/glib.h>
+
+static guint added;
+static guint resolved;
+
+static gboolean
+bl_func(BacklightAction a, const gchar *path, struct Backlight *bl)
+{
+    if (a == BL_ACTION_ADD)
+        added++;
+    else if (a == BL_ACTION_CHANGE)
+        resolved++;
+
+    return TRUE;
+}
+
+static void
+bench_backlights_startup(void)
+{
+    GMainContext *ctx = g_main_context_new();
+
+    added = resolved = 0;
+
+    g_test_timer_start();
+    Backlights *bls = backlights_new(ctx, bl_func);
+    gdouble published = g_test_timer_elapsed();
+
+    while (g_main_context_iteration(ctx, FALSE))
+        ;
+    gdouble ready = g_test_timer_elapsed();
+
+    g_test_minimized_result(published, "published %u backlights in %.6fs",
+            added, published);
+    g_test_message("resolved %u backlights in %.6fs", resolved, ready);
+
+    g_assert_cmpuint(resolved, <=, added);
+
+    backlights_free(bls);
+    g_main_context_unref(ctx);
+}
+
+int
+main(int argc, char *argv[])
+{
+    setlocale(LC_ALL, "");
+
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/backlight/startup", bench_backlights_startup);
+
+    return g_test_run();
+}
@@ -36,6 +36,10 @@ test_input(ConfigFixture *f, gconstpointer user_data)
     const Config *c = &f->c;
     g_assert_cmpuint(c->input_mask, ==, input_mask);
     g_assert_cmpuint(c->idle_sec, ==, 600);
+    g_assert_true(c->inhibit_on_fullscreen);
+#ifdef WIREPLUMBER
+    g_assert_true(c->inhibit_on_audio);
+#endif /* WIREPLUMBER */
 }
 
 static void
@@ -46,6 +50,14 @@ test_idle(ConfigFixture *f, gconstpointer user_data)
     g_assert_false(c->on_sleep);
 }
 
+static void
+test_dbus(ConfigFixture *f, gconstpointer user_data)
+{
+    const Config *c = &f->c;
+    g_assert_cmpuint(c->properties_interval_msec, ==, 100);
+    g_assert_false(c->broadcast_inactive);
+}
+
 static void
 test_dpms(ConfigFixture *f, gconstpointer user_data)
 {
@@ -67,12 +79,62 @@ test_backlights(ConfigFixture *f, gconstpointer user_data)
     g_assert_cmpuint(bl->dim_sec, ==, 600);
     g_assert_cmpint(bl->dim_percent, ==, 0.66);
     g_assert_cmpint(bl->dim_value, ==, -1);
+    g_assert_cmpuint(bl->curve, ==, BL_CURVE_LOG);
 
     struct BacklightConf *led = g_hash_table_lookup(bls, "/sys/class/leds/1");
     g_assert_nonnull(led);
     g_assert_cmpuint(led->dim_sec, ==, 600);
     g_assert_cmpint(led->dim_percent, ==, -1);
     g_assert_cmpint(led->dim_value, ==, 1);
+    g_assert_cmpuint(led->curve, ==, BL_CURVE_LINEAR);
+}
+
+static void
+test_backlight_groups(ConfigFixture *f, gconstpointer user_data)
+{
+    GHashTable *groups = f->c.backlight_groups;
+    g_assert_nonnull(groups);
+
+    struct BacklightGroupConf *g = g_hash_table_lookup(groups, "screens");
+    g_assert_nonnull(g);
+    g_assert_cmpstr(g->name, ==, "screens");
+    g_assert_cmpuint(g->conf.dim_sec, ==, 300);
+    g_assert_cmpint(g->conf.dim_value, ==, 10);
+    g_assert_cmpuint(g->members->len, ==, 2);
+
+    struct BacklightGroupMember *m = &g_array_index(g->members,
+            struct BacklightGroupMember, 0);
+    g_assert_cmpstr(m->path, ==, "/sys/class/backlight/1");
+    g_assert_cmpfloat(m->scale, ==, 1.0);
+
+    m = &g_array_index(g->members, struct BacklightGroupMember, 1);
+    g_assert_cmpstr(m->path, ==, "/sys/class/backlight/2");
+    g_assert_cmpfloat(m->scale, ==, 0.5);
+}
+
+static void
+test_backlight_dims(ConfigFixture *f, gconstpointer user_data)
+{
+    GHashTable *dims = f->c.backlight_dims;
+    g_assert_nonnull(dims);
+    g_assert_cmpuint(g_hash_table_size(dims), ==, 2);
+
+    GPtrArray *a = g_hash_table_lookup(dims, GUINT_TO_POINTER(600));
+    g_assert_nonnull(a);
+    g_assert_cmpuint(a->len, ==, 2);
+
+    a = g_hash_table_lookup(dims, GUINT_TO_POINTER(300));
+    g_assert_nonnull(a);
+    g_assert_cmpuint(a->len, ==, 2);
+    for (guint i = 0; i < a->len; i++) {
+        struct BacklightDim *d = g_ptr_array_index(a, i);
+        g_assert_cmpint(d->conf->dim_value, ==, 10);
+        g_assert_null(d->device);
+    }
+
+    a = g_hash_table_lookup(f->c.backlight_dim_paths, "/sys/class/backlight/1");
+    g_assert_nonnull(a);
+    g_assert_cmpuint(a->len, ==, 2);
 }
 
 int
@@ -91,8 +153,11 @@ main(int argc, char *argv[])
     TEST(load);
     TEST(input);
     TEST(idle);
+    TEST(dbus);
     TEST(dpms);
     TEST(backlights);
+    TEST(backlight_groups);
+    TEST(backlight_dims);
 #undef TEST
 
     int ret = g_test_run();
@@ -0,0 +1,79 @@
+#include "../src/events.h"
+
+#include <locale.h>
+#include <glib-2.0/glib.h>
+
+#define SIZE 4
+
+typedef struct {
+    Events *e;
+} EventsFixture;
+
+static void
+events_fixture_set_up(EventsFixture *f, gconstpointer user_data)
+{
+    f->e = events_new(SIZE);
+}
+
+static void
+events_fixture_tear_down(EventsFixture *f, gconstpointer user_data)
+{
+    events_free(f->e);
+}
+
+static void
+test_events_push(EventsFixture *f, gconstpointer user_data)
+{
+    g_assert_cmpuint(events_first_seq(f->e), ==, 1);
+    g_assert_null(events_get(f->e, 1));
+
+    const struct Event *ev = events_push(f->e, "Lock",
+            g_variant_new("(b)", TRUE));
+
+    g_assert_cmpuint(ev->seq, ==, 1);
+    g_assert_true(events_get(f->e, 1) == ev);
+    g_assert_cmpstr(ev->name, ==, "Lock");
+    g_assert_true(g_variant_is_of_type(ev->data, G_VARIANT_TYPE("(b)")));
+    g_assert_null(events_get(f->e, 0));
+    g_assert_null(events_get(f->e, 2));
+}
+
+static void
+test_events_wrap(EventsFixture *f, gconstpointer user_data)
+{
+    for (guint i = 1; i <= SIZE * 2 + 1; i++)
+        events_push(f->e, "Inactive", g_variant_new("(u)", i));
+
+    g_assert_cmpuint(events_first_seq(f->e), ==, SIZE + 2);
+    g_assert_null(events_get(f->e, SIZE + 1));
+
+    for (guint64 seq = SIZE + 2; seq <= SIZE * 2 + 1; seq++) {
+        const struct Event *ev = events_get(f->e, seq);
+        guint32 v;
+
+        g_assert_nonnull(ev);
+        g_assert_cmpuint(ev->seq, ==, seq);
+        g_variant_get(ev->data, "(u)", &v);
+        g_assert_cmpuint(v, ==, seq);
+    }
+}
+
+int
+main(int argc, char *argv[])
+{
+    setlocale(LC_ALL, "");
+
+    g_test_init(&argc, &argv, NULL);
+
+#define TEST(name) \
+    g_test_add("/events/" #name, EventsFixture, NULL, \
+            events_fixture_set_up, test_events_##name, \
+            events_fixture_tear_down)
+
+    TEST(push);
+    TEST(wrap);
+
+#undef TEST
+
+    return g_test_run();
+}
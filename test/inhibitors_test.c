@@ -0,0 +1,171 @@
+#include "../src/inhibitors.h"
+
+#include <locale.h>
+#include <glib-2.0/glib.h>
+
+typedef struct {
+    Inhibitors *s;
+} InhibitorsFixture;
+
+static void
+inhibitors_fixture_set_up(InhibitorsFixture *f, gconstpointer user_data)
+{
+    f->s = inhibitors_new();
+}
+
+static void
+inhibitors_fixture_tear_down(InhibitorsFixture *f, gconstpointer user_data)
+{
+    inhibitors_free(f->s);
+}
+
+static void
+test_inhibitors_add_remove(InhibitorsFixture *f, gconstpointer user_data)
+{
+    struct Inhibitor *a = inhibitors_add(f->s, "a", "test");
+    struct Inhibitor *b = inhibitors_add(f->s, "b", "test");
+
+    g_assert_true(g_uuid_string_is_valid(a->id));
+    g_assert_cmpuint(inhibitors_size(f->s), ==, 2);
+    g_assert_true(inhibitors_lookup(f->s, a->id) == a);
+
+    /* who/why strings are interned */
+    g_assert_true(a->why == b->why);
+
+    struct Inhibitor *i = inhibitors_steal(f->s, a->id);
+    g_assert_true(i == a);
+    g_assert_null(inhibitors_lookup(f->s, a->id));
+    g_assert_null(inhibitors_steal(f->s, a->id));
+    inhibitor_free(i);
+
+    g_assert_cmpuint(inhibitors_size(f->s), ==, 1);
+}
+
+static void
+test_inhibitors_order(InhibitorsFixture *f, gconstpointer user_data)
+{
+    const gchar *who[] = {"a", "b", "c"};
+
+    for (guint n = 0; n < G_N_ELEMENTS(who); n++)
+        inhibitors_add(f->s, who[n], "test");
+
+    for (guint n = 0; n < G_N_ELEMENTS(who); n++) {
+        struct Inhibitor *i = inhibitors_pop(f->s);
+        g_assert_cmpstr(i->who, ==, who[n]);
+        inhibitor_free(i);
+    }
+
+    g_assert_null(inhibitors_pop(f->s));
+}
+
+static void
+test_inhibitors_list(InhibitorsFixture *f, gconstpointer user_data)
+{
+    GVariant *v = inhibitors_list(f->s);
+    g_assert_cmpuint(g_variant_n_children(v), ==, 0);
+
+    struct Inhibitor *a = inhibitors_add(f->s, "a", "test");
+    v = inhibitors_list(f->s);
+    g_assert_cmpuint(g_variant_n_children(v), ==, 1);
+
+    /* cached until modified */
+    g_assert_true(inhibitors_list(f->s) == v);
+
+    gint64 timestamp;
+    const gchar *who;
+    const gchar *why;
+    g_assert_true(g_variant_lookup(v, a->id, "(t&s&s)", &timestamp, &who,
+                &why));
+    g_assert_cmpint(timestamp, ==, a->timestamp);
+    g_assert_cmpstr(who, ==, "a");
+    g_assert_cmpstr(why, ==, "test");
+
+    v = inhibitors_list_expiries(f->s);
+    g_assert_cmpuint(g_variant_n_children(v), ==, 0);
+
+    inhibitors_set_expiry(f->s, a, g_get_monotonic_time() + 30 * G_USEC_PER_SEC);
+    v = inhibitors_list_expiries(f->s);
+    guint64 remaining;
+    g_assert_true(g_variant_lookup(v, a->id, "t", &remaining));
+    g_assert_cmpuint(remaining, ==, 30);
+
+    inhibitor_free(inhibitors_steal(f->s, a->id));
+    g_assert_cmpuint(g_variant_n_children(inhibitors_list(f->s)), ==, 0);
+}
+
+static void
+test_inhibitors_expiry(InhibitorsFixture *f, gconstpointer user_data)
+{
+    gint64 now = g_get_monotonic_time();
+    struct Inhibitor *a = inhibitors_add(f->s, "a", "test");
+    struct Inhibitor *b = inhibitors_add(f->s, "b", "test");
+    struct Inhibitor *c = inhibitors_add(f->s, "c", "test");
+
+    g_assert_cmpint(inhibitors_next_expiry(f->s), ==, -1);
+
+    inhibitors_set_expiry(f->s, a, now + 20);
+    inhibitors_set_expiry(f->s, b, now + 10);
+    g_assert_cmpint(inhibitors_next_expiry(f->s), ==, now + 10);
+
+    g_assert_null(inhibitors_pop_expired(f->s, now));
+
+    struct Inhibitor *i = inhibitors_pop_expired(f->s, now + 15);
+    g_assert_true(i == b);
+    inhibitor_free(i);
+    g_assert_null(inhibitors_pop_expired(f->s, now + 15));
+    g_assert_cmpint(inhibitors_next_expiry(f->s), ==, now + 20);
+
+    /* removing an inhibitor removes its expiry */
+    inhibitor_free(inhibitors_steal(f->s, a->id));
+    g_assert_cmpint(inhibitors_next_expiry(f->s), ==, -1);
+    g_assert_true(inhibitors_lookup(f->s, c->id) == c);
+}
+
+static void
+test_inhibitors_timeout(InhibitorsFixture *f, gconstpointer user_data)
+{
+    gint64 now = g_get_monotonic_time();
+    struct Inhibitor *a = inhibitors_add(f->s, "a", "test");
+    guint sec = 6 * 60 * 60;
+
+    /* beyond the range of 32-bit microseconds */
+    inhibitors_set_timeout(f->s, a, now, sec);
+    g_assert_cmpint(inhibitors_next_expiry(f->s), ==,
+            now + (gint64)sec * G_USEC_PER_SEC);
+    g_assert_null(inhibitors_pop_expired(f->s, now + G_USEC_PER_SEC));
+
+    inhibitors_set_timeout(f->s, a, now, INHIBITOR_MAX_SEC);
+    g_assert_cmpint(inhibitors_next_expiry(f->s), >, now);
+
+    inhibitors_set_timeout(f->s, a, now, 0);
+    g_assert_cmpint(inhibitors_next_expiry(f->s), ==, -1);
+
+    inhibitors_set_timeout(f->s, a, now, sec);
+    struct Inhibitor *i = inhibitors_pop_expired(f->s,
+            now + (gint64)sec * G_USEC_PER_SEC);
+    g_assert_true(i == a);
+    inhibitor_free(i);
+}
+
+int
+main(int argc, char *argv[])
+{
+    setlocale(LC_ALL, "");
+
+    g_test_init(&argc, &argv, NULL);
+
+#define TEST(name) \
+    g_test_add("/inhibitors/" #name, InhibitorsFixture, NULL, \
+            inhibitors_fixture_set_up, test_inhibitors_##name, \
+            inhibitors_fixture_tear_down)
+
+    TEST(add_remove);
+    TEST(order);
+    TEST(list);
+    TEST(expiry);
+    TEST(timeout);
+
+#undef TEST
+
+    return g_test_run();
+}
@@ -0,0 +1,168 @@
+#include "../src/json.h"
+
+#include <locale.h>
+#include <glib-2.0/glib.h>
+
+typedef struct {
+    GString *out;
+} JsonFixture;
+
+static void
+json_fixture_set_up(JsonFixture *f, gconstpointer user_data)
+{
+    f->out = g_string_new(NULL);
+}
+
+static void
+json_fixture_tear_down(JsonFixture *f, gconstpointer user_data)
+{
+    g_string_free(f->out, TRUE);
+}
+
+static void
+assert_round_trip(JsonFixture *f, const gchar *str, const gchar *expected)
+{
+    GError *err = NULL;
+    GVariant *v = json_parse(str, &err);
+
+    g_assert_no_error(err);
+    g_string_truncate(f->out, 0);
+    json_append(f->out, v);
+    g_assert_cmpstr(f->out->str, ==, expected);
+    g_variant_unref(v);
+}
+
+static void
+test_json_parse(JsonFixture *f, gconstpointer user_data)
+{
+    assert_round_trip(f, " true ", "true");
+    assert_round_trip(f, "null", "null");
+    assert_round_trip(f, "-42", "-42");
+    assert_round_trip(f, "0.5", "0.5");
+    assert_round_trip(f, "1e2", "100");
+    assert_round_trip(f, "\"a\\\"b\\u00e9\\ud83d\\ude00\\n\"",
+            "\"a\\\"b\xc3\xa9\xf0\x9f\x98\x80\\n\"");
+    assert_round_trip(f, "[1, [\"x\"], {}]", "[1,[\"x\"],{}]");
+    assert_round_trip(f, "{\"a\": 1, \"b\": [true, null]}",
+            "{\"a\":1,\"b\":[true,null]}");
+
+    GVariant *v = json_parse("9223372036854775807", NULL);
+    g_assert_true(g_variant_is_of_type(v, G_VARIANT_TYPE_INT64));
+    g_assert_cmpint(g_variant_get_int64(v), ==, G_MAXINT64);
+    g_variant_unref(v);
+}
+
+static void
+test_json_invalid(JsonFixture *f, gconstpointer user_data)
+{
+    const gchar *invalid[] = {
+        "", "tru", "01", "1.", "-", "[1,]", "{\"a\"}", "{\"a\":1,}", "[1 2]",
+        "\"abc", "\"\\x\"", "\"\\u0000\"", "\"\\ud800\"", "\"a\tb\"",
+        "1 2", "\xff", NULL,
+    };
+
+    for (const gchar **s = invalid; *s; s++) {
+        GError *err = NULL;
+        g_assert_null(json_parse(*s, &err));
+        g_assert_error(err, JSON_ERROR, JSON_ERROR_PARSE);
+        g_error_free(err);
+    }
+
+    GString *deep = g_string_new(NULL);
+    for (guint i = 0; i < 100; i++)
+        g_string_append_c(deep, '[');
+    for (guint i = 0; i < 100; i++)
+        g_string_append_c(deep, ']');
+    g_assert_null(json_parse(deep->str, NULL));
+    g_string_free(deep, TRUE);
+}
+
+static GVariant *
+convert(const gchar *str, const gchar *type, GError **err)
+{
+    GVariant *v = json_parse(str, NULL);
+    g_assert_nonnull(v);
+
+    GVariant *ret = json_convert(v, G_VARIANT_TYPE(type), err);
+    g_variant_unref(v);
+
+    return ret ? g_variant_ref_sink(ret) : NULL;
+}
+
+static void
+test_json_convert(JsonFixture *f, gconstpointer user_data)
+{
+    GVariant *v = convert("[10, 0.5, \"/a/b\", null, [1, 2], {\"x\": true}]",
+            "(udomiaia{sb})", NULL);
+    g_assert_nonnull(v);
+
+    gchar *str = g_variant_print(v, FALSE);
+    g_assert_cmpstr(str, ==,
+            "(10, 0.5, '/a/b', nothing, [1, 2], {'x': true})");
+    g_free(str);
+    g_variant_unref(v);
+
+    gint32 n;
+
+    v = convert("[\"s\", 2.0]", "(vi)", NULL);
+    g_assert_nonnull(v);
+    g_variant_get(v, "(vi)", NULL, &n);
+    g_assert_cmpint(n, ==, 2);
+    g_variant_unref(v);
+
+    const gchar *invalid[][2] = {
+        {"[-1]", "(u)"},
+        {"[4294967296]", "(u)"},
+        {"[1.5]", "(i)"},
+        {"[\"1\"]", "(i)"},
+        {"[1]", "(b)"},
+        {"[\"a b\"]", "(o)"},
+        {"[null]", "(s)"},
+        {"[1, 2]", "(i)"},
+        {"{\"x\": 1}", "a{ss}"},
+        {NULL, NULL},
+    };
+
+    for (guint i = 0; invalid[i][0]; i++) {
+        GError *err = NULL;
+        g_assert_null(convert(invalid[i][0], invalid[i][1], &err));
+        g_assert_error(err, JSON_ERROR, JSON_ERROR_TYPE);
+        g_error_free(err);
+    }
+}
+
+static void
+test_json_append(JsonFixture *f, gconstpointer user_data)
+{
+    GVariant *v = g_variant_ref_sink(g_variant_new_parsed(
+                "(@o '/x', <uint32 3>, {uint32 1: 'a'}, [0.25, 1e300],"
+                " @ms nothing, 'q\"\\\\\\t\\u0001')"));
+
+    json_append(f->out, v);
+    g_assert_cmpstr(f->out->str, ==,
+            "[\"/x\",3,{\"1\":\"a\"},[0.25,1.0000000000000001e+300],null,"
+            "\"q\\\"\\\\\\t\\u0001\"]");
+
+    g_variant_unref(v);
+}
+
+int
+main(int argc, char *argv[])
+{
+    setlocale(LC_ALL, "");
+
+    g_test_init(&argc, &argv, NULL);
+
+#define TEST(name) \
+    g_test_add("/json/" #name, JsonFixture, NULL, json_fixture_set_up, \
+            test_json_##name, json_fixture_tear_down)
+
+    TEST(parse);
+    TEST(invalid);
+    TEST(convert);
+    TEST(append);
+
+#undef TEST
+
+    return g_test_run();
+}
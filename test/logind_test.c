@@ -0,0 +1,101 @@
+#include "../src/dbus-logind.h"
+
+#include <locale.h>
+#include <glib-2.0/glib.h>
+
+typedef struct {
+    GQueue *requests;
+} LogindFixture;
+
+static void
+logind_fixture_set_up(LogindFixture *f, gconstpointer user_data)
+{
+    f->requests = g_queue_new();
+}
+
+static void
+free_request(gpointer data)
+{
+    LogindRequest *r = (LogindRequest *)data;
+
+    g_free(r->method);
+    g_variant_unref(r->params);
+    g_free(r);
+}
+
+static void
+logind_fixture_tear_down(LogindFixture *f, gconstpointer user_data)
+{
+    g_queue_free_full(f->requests, free_request);
+}
+
+/* Queue a call as logind_call does, unless it is pending. */
+static gboolean
+call(LogindFixture *f, const gchar *method, GVariant *params)
+{
+    if (!params)
+        params = g_variant_new("()");
+    g_variant_ref_sink(params);
+
+    if (logind_request_pending(f->requests, method, params)) {
+        g_variant_unref(params);
+        return FALSE;
+    }
+
+    LogindRequest *r = g_malloc0(sizeof(LogindRequest));
+    r->method = g_strdup(method);
+    r->params = params;
+    g_queue_push_tail(f->requests, r);
+
+    return TRUE;
+}
+
+static void
+test_logind_pending(LogindFixture *f, gconstpointer user_data)
+{
+    g_assert_true(call(f, "Lock", NULL));
+    g_assert_false(call(f, "Lock", NULL));
+
+    g_assert_true(call(f, "SetIdleHint", g_variant_new("(b)", TRUE)));
+    g_assert_false(call(f, "SetIdleHint", g_variant_new("(b)", TRUE)));
+    g_assert_true(call(f, "SetIdleHint", g_variant_new("(b)", FALSE)));
+
+    g_assert_cmpuint(g_queue_get_length(f->requests), ==, 3);
+}
+
+/* A call must not be dropped because an identical one is queued before a
+ * call that undoes it. */
+static void
+test_logind_interleaved(LogindFixture *f, gconstpointer user_data)
+{
+    g_assert_true(call(f, "Lock", NULL));
+    g_assert_true(call(f, "Unlock", NULL));
+    g_assert_true(call(f, "Lock", NULL));
+
+    g_assert_true(call(f, "SetLockedHint", g_variant_new("(b)", TRUE)));
+    g_assert_true(call(f, "SetIdleHint", g_variant_new("(b)", TRUE)));
+    g_assert_true(call(f, "SetLockedHint", g_variant_new("(b)", FALSE)));
+    g_assert_true(call(f, "SetLockedHint", g_variant_new("(b)", TRUE)));
+
+    g_assert_cmpuint(g_queue_get_length(f->requests), ==, 7);
+
+    LogindRequest *r = g_queue_peek_nth(f->requests, 2);
+    g_assert_cmpstr(r->method, ==, "Lock");
+}
+
+int
+main(int argc, char *argv[])
+{
+    setlocale(LC_ALL, "");
+
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add("/logind/pending", LogindFixture, NULL,
+            logind_fixture_set_up, test_logind_pending,
+            logind_fixture_tear_down);
+    g_test_add("/logind/interleaved", LogindFixture, NULL,
+            logind_fixture_set_up, test_logind_interleaved,
+            logind_fixture_tear_down);
+
+    return g_test_run();
+}
@@ -0,0 +1,138 @@
+#include "../src/progress.h"
+
+#include <locale.h>
+#include <glib-2.0/glib.h>
+
+typedef struct {
+    GMainContext *ctx;
+    GMainLoop *loop;
+    Progress *p;
+    GArray *elapsed;
+    guint stop_at;
+    guint quit_at;
+} ProgressFixture;
+
+static void
+progress_func(guint elapsed, gpointer user_data)
+{
+    ProgressFixture *f = (ProgressFixture *)user_data;
+
+    g_array_append_val(f->elapsed, elapsed);
+
+    if (elapsed == f->stop_at)
+        progress_stop(f->p);
+    if (elapsed == f->quit_at)
+        g_main_loop_quit(f->loop);
+}
+
+static gboolean
+quit_loop(gpointer user_data)
+{
+    g_main_loop_quit(((ProgressFixture *)user_data)->loop);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+progress_fixture_set_up(ProgressFixture *f, gconstpointer user_data)
+{
+    f->ctx = g_main_context_new();
+    f->loop = g_main_loop_new(f->ctx, FALSE);
+    f->p = progress_new(f->ctx, progress_func, f);
+    f->elapsed = g_array_new(FALSE, FALSE, sizeof(guint));
+    f->stop_at = 0;
+    f->quit_at = 0;
+}
+
+static void
+progress_fixture_tear_down(ProgressFixture *f, gconstpointer user_data)
+{
+    g_array_unref(f->elapsed);
+    progress_free(f->p);
+    g_main_loop_unref(f->loop);
+    g_main_context_unref(f->ctx);
+}
+
+#define ELAPSED(f, i) g_array_index((f)->elapsed, guint, i)
+
+static void
+test_progress_intervals(ProgressFixture *f, gconstpointer user_data)
+{
+    g_assert_cmpuint(progress_min_interval(f->p), ==, 0);
+
+    progress_add_interval(f->p, 3);
+    progress_add_interval(f->p, 2);
+    progress_add_interval(f->p, 2);
+    g_assert_cmpuint(progress_min_interval(f->p), ==, 2);
+
+    progress_remove_interval(f->p, 2);
+    g_assert_cmpuint(progress_min_interval(f->p), ==, 2);
+
+    progress_remove_interval(f->p, 2);
+    g_assert_cmpuint(progress_min_interval(f->p), ==, 3);
+
+    progress_remove_interval(f->p, 3);
+    progress_start(f->p);
+    g_assert_false(progress_running(f->p));
+    g_assert_cmpuint(f->elapsed->len, ==, 0);
+}
+
+static void
+test_progress_run(ProgressFixture *f, gconstpointer user_data)
+{
+    progress_add_interval(f->p, 2);
+    progress_add_interval(f->p, 3);
+    f->quit_at = 4;
+
+    progress_start(f->p);
+    g_assert_true(progress_running(f->p));
+    g_main_loop_run(f->loop);
+
+    g_assert_cmpuint(f->elapsed->len, ==, 3);
+    g_assert_cmpuint(ELAPSED(f, 0), ==, 2);
+    g_assert_cmpuint(ELAPSED(f, 1), ==, 3);
+    g_assert_cmpuint(ELAPSED(f, 2), ==, 4);
+}
+
+/* Inhibiting stops progress; it must not advance while stopped and must
+ * begin again from the shortest interval. */
+static void
+test_progress_stop(ProgressFixture *f, gconstpointer user_data)
+{
+    progress_add_interval(f->p, 1);
+    f->stop_at = 2;
+
+    progress_start(f->p);
+    GSource *quit = g_timeout_source_new_seconds(4);
+    g_source_set_callback(quit, quit_loop, f, NULL);
+    g_source_attach(quit, f->ctx);
+    g_source_unref(quit);
+    g_main_loop_run(f->loop);
+
+    g_assert_false(progress_running(f->p));
+    g_assert_cmpuint(f->elapsed->len, ==, 2);
+    g_assert_cmpuint(ELAPSED(f, 1), ==, 2);
+
+    progress_start(f->p);
+    g_assert_cmpuint(f->elapsed->len, ==, 3);
+    g_assert_cmpuint(ELAPSED(f, 2), ==, 1);
+}
+
+int
+main(int argc, char *argv[])
+{
+    setlocale(LC_ALL, "");
+
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add("/progress/intervals", ProgressFixture, NULL,
+            progress_fixture_set_up, test_progress_intervals,
+            progress_fixture_tear_down);
+    g_test_add("/progress/run", ProgressFixture, NULL,
+            progress_fixture_set_up, test_progress_run,
+            progress_fixture_tear_down);
+    g_test_add("/progress/stop", ProgressFixture, NULL,
+            progress_fixture_set_up, test_progress_stop,
+            progress_fixture_tear_down);
+
+    return g_test_run();
+}
@@ -0,0 +1,127 @@
+#include "../src/state-file.h"
+#include "../src/sessiond-state.h"
+
+#include <locale.h>
+#include <glib-2.0/glib.h>
+#include <glib-2.0/glib/gstdio.h>
+
+typedef struct {
+    gchar *dir;
+    gchar *path;
+    StateFile *f;
+} StateFileFixture;
+
+static void
+state_file_fixture_set_up(StateFileFixture *f, gconstpointer user_data)
+{
+    f->dir = g_dir_make_tmp("sessiond-XXXXXX", NULL);
+    g_assert_nonnull(f->dir);
+    g_setenv("XDG_RUNTIME_DIR", f->dir, TRUE);
+    f->path = g_build_filename(f->dir, SESSIOND_STATE_FILE, NULL);
+    f->f = state_file_new(f->path);
+    g_assert_nonnull(f->f);
+}
+
+static void
+state_file_fixture_tear_down(StateFileFixture *f, gconstpointer user_data)
+{
+    state_file_free(f->f);
+    g_unlink(f->path);
+    gchar *dir = g_path_get_dirname(f->path);
+    g_rmdir(dir);
+    g_free(dir);
+    g_rmdir(f->dir);
+    g_free(f->path);
+    g_free(f->dir);
+}
+
+static void
+test_state_file_read(StateFileFixture *f, gconstpointer user_data)
+{
+    const struct sessiond_state *s = sessiond_state_open();
+    struct sessiond_state st;
+
+    g_assert_nonnull(s);
+
+    guint32 seq = sessiond_state_read(s, &st);
+    g_assert_cmpuint(seq % 2, ==, 0);
+    g_assert_cmpuint(st.flags, ==, SESSIOND_STATE_RUNNING);
+    g_assert_cmpint(st.default_audiosink, ==, -1);
+
+    state_file_begin(f->f);
+    f->f->state->flags |= SESSIOND_STATE_LOCKED;
+    f->f->state->n_backlights = 1;
+    f->f->state->backlights[0].brightness = 42;
+    state_file_end(f->f);
+    state_file_set_activity(f->f, 1234);
+
+    g_assert_cmpuint(sessiond_state_read(s, &st), ==, seq + 2);
+    g_assert_cmpuint(st.flags & SESSIOND_STATE_LOCKED, !=, 0);
+    g_assert_cmpuint(st.backlights[0].brightness, ==, 42);
+    g_assert_cmpuint(st.last_activity, ==, 1234);
+
+    sessiond_state_close(s);
+}
+
+static void
+test_state_file_wait(StateFileFixture *f, gconstpointer user_data)
+{
+    const struct sessiond_state *s = sessiond_state_open();
+    struct sessiond_state st;
+    struct timespec timeout = {0, 10 * 1000 * 1000};
+
+    g_assert_nonnull(s);
+
+    guint32 seq = sessiond_state_read(s, &st);
+    g_assert_cmpint(sessiond_state_wait(s, seq, &timeout), ==, -1);
+    g_assert_cmpint(errno, ==, ETIMEDOUT);
+
+    state_file_begin(f->f);
+    state_file_end(f->f);
+    g_assert_cmpint(sessiond_state_wait(s, seq, &timeout), ==, 0);
+
+    sessiond_state_close(s);
+}
+
+/* A restarted writer reuses the file and keeps the sequence increasing. */
+static void
+test_state_file_reopen(StateFileFixture *f, gconstpointer user_data)
+{
+    const struct sessiond_state *s = sessiond_state_open();
+    struct sessiond_state st;
+
+    g_assert_nonnull(s);
+
+    guint32 seq = sessiond_state_read(s, &st);
+
+    state_file_free(f->f);
+    sessiond_state_read(s, &st);
+    g_assert_cmpuint(st.flags, ==, 0);
+
+    f->f = state_file_new(f->path);
+    g_assert_cmpuint(sessiond_state_read(s, &st), >, seq);
+    g_assert_cmpuint(st.flags, ==, SESSIOND_STATE_RUNNING);
+
+    sessiond_state_close(s);
+}
+
+int
+main(int argc, char *argv[])
+{
+    setlocale(LC_ALL, "");
+
+    g_test_init(&argc, &argv, NULL);
+
+#define TEST(name) \
+    g_test_add("/state_file/" #name, StateFileFixture, NULL, \
+            state_file_fixture_set_up, test_state_file_##name, \
+            state_file_fixture_tear_down)
+
+    TEST(read);
+    TEST(wait);
+    TEST(reopen);
+
+#undef TEST
+
+    return g_test_run();
+}
@@ -0,0 +1,82 @@
+#include "../src/throttle.h"
+
+#include <locale.h>
+#include <glib-2.0/glib.h>
+
+typedef struct {
+    Throttle *t;
+    guint runs;
+} ThrottleFixture;
+
+static void
+on_run(gpointer user_data)
+{
+    ThrottleFixture *f = (ThrottleFixture *)user_data;
+    f->runs++;
+}
+
+static void
+throttle_fixture_set_up(ThrottleFixture *f, gconstpointer user_data)
+{
+    f->t = throttle_new(50, on_run, f, NULL);
+    f->runs = 0;
+}
+
+static void
+throttle_fixture_tear_down(ThrottleFixture *f, gconstpointer user_data)
+{
+    throttle_free(f->t);
+}
+
+static void
+test_throttle_coalesce(ThrottleFixture *f, gconstpointer user_data)
+{
+    /* The first request runs at once. */
+    throttle_queue(f->t);
+    g_assert_cmpuint(f->runs, ==, 1);
+
+    for (guint i = 0; i < 10; i++)
+        throttle_queue(f->t);
+    g_assert_cmpuint(f->runs, ==, 1);
+    g_assert_true(throttle_pending(f->t));
+
+    g_test_timer_start();
+    while (throttle_pending(f->t))
+        g_main_context_iteration(NULL, TRUE);
+
+    g_assert_cmpuint(f->runs, ==, 2);
+    g_assert_cmpfloat(g_test_timer_elapsed(), <=, 0.5);
+}
+
+static void
+test_throttle_flush(ThrottleFixture *f, gconstpointer user_data)
+{
+    throttle_flush(f->t);
+    g_assert_cmpuint(f->runs, ==, 0);
+
+    throttle_queue(f->t);
+    throttle_queue(f->t);
+    throttle_flush(f->t);
+    g_assert_cmpuint(f->runs, ==, 2);
+    g_assert_false(throttle_pending(f->t));
+}
+
+int
+main(int argc, char *argv[])
+{
+    setlocale(LC_ALL, "");
+
+    g_test_init(&argc, &argv, NULL);
+
+#define TEST(name) \
+    g_test_add("/throttle/" #name, ThrottleFixture, NULL, \
+            throttle_fixture_set_up, test_throttle_##name, \
+            throttle_fixture_tear_down)
+
+    TEST(coalesce);
+    TEST(flush);
+
+#undef TEST
+
+    return g_test_run();
+}
@@ -59,6 +59,98 @@ test_timeline_timeout(TimelineFixture *f, gconstpointer user_data)
         g_assert_cmpint(g_array_index(f->times, double, i), <=, timeouts[i]);
 }
 
+static gboolean
+quit_loop(gpointer user_data)
+{
+    g_main_loop_quit((GMainLoop *)user_data);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+test_timeline_add_after_end(TimelineFixture *f, gconstpointer user_data)
+{
+    timeline_add_timeout(&f->tl, 1);
+
+    timeline_start(&f->tl);
+    g_test_timer_start();
+    g_main_loop_run(f->loop);
+    g_assert_cmpint(f->times->len, ==, 1);
+
+    /* added once all timeouts have fired */
+    timeline_add_timeout(&f->tl, 2);
+    g_assert_cmpuint(timeline_pending_timeouts(&f->tl), ==, 1);
+
+    GSource *source = g_timeout_source_new_seconds(5);
+    g_source_set_callback(source, quit_loop, f->loop, NULL);
+    g_source_attach(source, f->ctx);
+    g_main_loop_run(f->loop);
+    g_source_destroy(source);
+    g_source_unref(source);
+    timeline_stop(&f->tl);
+
+    g_assert_cmpint(f->times->len, ==, 2);
+    g_assert_cmpfloat(g_array_index(f->times, double, 1), >=, 1);
+    g_assert_cmpfloat(g_array_index(f->times, double, 1), <, 5);
+}
+
+static void
+test_timeline_refs(TimelineFixture *f, gconstpointer user_data)
+{
+    g_assert_true(timeline_add_timeout(&f->tl, 10));
+    g_assert_false(timeline_add_timeout(&f->tl, 10));
+
+    timeline_ref_timeout(&f->tl, 10);
+    timeline_ref_timeout(&f->tl, 20);
+    timeline_ref_timeout(&f->tl, 20);
+    g_assert_cmpuint(timeline_pending_timeouts(&f->tl), ==, 2);
+
+    g_assert_true(timeline_remove_timeout(&f->tl, 10));
+    g_assert_false(timeline_remove_timeout(&f->tl, 10));
+    g_assert_cmpuint(timeline_pending_timeouts(&f->tl), ==, 2);
+
+    timeline_unref_timeout(&f->tl, 10);
+    timeline_unref_timeout(&f->tl, 20);
+    g_assert_cmpuint(timeline_pending_timeouts(&f->tl), ==, 1);
+
+    timeline_add_timeout(&f->tl, 30);
+    timeline_clear(&f->tl);
+    g_assert_cmpuint(timeline_pending_timeouts(&f->tl), ==, 1);
+
+    timeline_unref_timeout(&f->tl, 20);
+    g_assert_cmpuint(timeline_pending_timeouts(&f->tl), ==, 0);
+}
+
+static gpointer
+run_loop(gpointer user_data)
+{
+    TimelineFixture *f = (TimelineFixture *)user_data;
+
+    g_main_context_push_thread_default(f->ctx);
+    g_main_loop_run(f->loop);
+    g_main_context_pop_thread_default(f->ctx);
+
+    return NULL;
+}
+
+static void
+test_timeline_thread(TimelineFixture *f, gconstpointer user_data)
+{
+    GThread *thread = g_thread_new("timeline", run_loop, f);
+    f->tl.thread = thread;
+
+    /* results are returned from the timeline's thread */
+    g_assert_true(timeline_add_timeout(&f->tl, 10));
+    g_assert_false(timeline_add_timeout(&f->tl, 10));
+    g_assert_true(timeline_remove_timeout(&f->tl, 10));
+    g_assert_false(timeline_remove_timeout(&f->tl, 10));
+
+    g_main_context_invoke(f->ctx, quit_loop, f->loop);
+    g_thread_join(thread);
+    f->tl.thread = NULL;
+
+    g_assert_cmpuint(timeline_pending_timeouts(&f->tl), ==, 0);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -68,6 +160,13 @@ main(int argc, char *argv[])
 
     g_test_add("/timeline/timeout", TimelineFixture, NULL,
             tl_fixture_set_up, test_timeline_timeout, tl_fixture_tear_down);
+    g_test_add("/timeline/add_after_end", TimelineFixture, NULL,
+            tl_fixture_set_up, test_timeline_add_after_end,
+            tl_fixture_tear_down);
+    g_test_add("/timeline/thread", TimelineFixture, NULL,
+            tl_fixture_set_up, test_timeline_thread, tl_fixture_tear_down);
+    g_test_add("/timeline/refs", TimelineFixture, NULL,
+            tl_fixture_set_up, test_timeline_refs, tl_fixture_tear_down);
 
     return g_test_run();
 }